@@ -13,9 +13,62 @@ public:
     }
     virtual bool isDefined(const Field&) const = 0;
     virtual std::ostream& print(std::ostream& os) const = 0;
+    /**
+     * @brief Where the vacant place is moved to
+     */
+    virtual Direction direction() const = 0;
+    /**
+     * @brief Where the vacant place is moved from
+     */
+    virtual Position from() const = 0;
+    /**
+     * @brief Cost of taking the action on `origin`
+     */
+    virtual unsigned cost(const Field& origin) const {
+        return 1;
+    }
     virtual ~FifteenAction() {}
 };
 
+/**
+ * @brief Action costing as much as the number of the tile it moves
+ */
+class TileWeightedAction: public FifteenAction {
+    const FifteenAction* action;
+
+public:
+    explicit TileWeightedAction(const FifteenAction* _action):
+        action(_action)
+    {}
+
+    Field operator()(const Field& f) const {
+        return (*action)(f);
+    }
+
+    bool isDefined(const Field& f) const {
+        return action->isDefined(f);
+    }
+
+    std::ostream& print(std::ostream& os) const {
+        return action->print(os);
+    }
+
+    Direction direction() const {
+        return action->direction();
+    }
+
+    Position from() const {
+        return action->from();
+    }
+
+    unsigned cost(const Field& origin) const {
+        Direction d = direction();
+        Position to(from().row + (d == Down) - (d == Up), from().column + (d == Right) - (d == Left));
+
+        return origin.at(to).get().value;
+    }
+};
+
 template<int D_ROW, int D_COL>
 class MoveAction: public FifteenAction {
 public:
@@ -54,6 +107,14 @@ public:
         return os;
     }
 
+    Direction direction() const {
+        return D_ROW < 0 ? Up : D_ROW > 0 ? Down : D_COL < 0 ? Left : Right;
+    }
+
+    Position from() const {
+        return move_from;
+    }
+
 
     ~MoveAction() {}
 
@@ -69,4 +130,16 @@ typedef MoveAction< 0,  1> MoveRight;
 typedef MoveAction<-1,  0> MoveUp;
 typedef MoveAction< 1,  0> MoveDown;
 
+/**
+ * @brief Every move of the vacant place from every place of `f`
+ */
+inline void allPossibleActions(const Field& f, std::vector<FifteenAction*>& actions) {
+    for(Field::const_iterator it = f.begin(); it != f.end(); ++it) {
+        actions.push_back(new MoveLeft(it->position));
+        actions.push_back(new MoveRight(it->position));
+        actions.push_back(new MoveUp(it->position));
+        actions.push_back(new MoveDown(it->position));
+    }
+}
+
 #endif // ACTIONS_H
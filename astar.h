@@ -7,38 +7,106 @@
 #include <unordered_set>
 #include <algorithm>
 #include <vector>
+#include <memory>
 #include <iostream>
 #include <assert.h>
-
-typedef int Cost;
-
+#include "cost.h"
+#include "transposition.h"
+#include "timeline.h"
+
+/**
+ * Actions are kept as a chain from the last one back, shared by every domain
+ * reached through the same actions, so reaching a domain from another one
+ * takes constant time; actions() lays the chain out only when asked.
+ */
 template <typename Domain, typename ActionPtr>
 class TracedDomain {
 private:
+    struct Step {
+        ActionPtr action;
+        std::shared_ptr<const Step> before;
+
+        Step(const ActionPtr& _action, const std::shared_ptr<const Step>& _before):
+            action(_action),
+            before(_before)
+        {}
+    };
+
     Domain d;
-    std::vector<ActionPtr> aa;
+    std::shared_ptr<const Step> last;
+    size_t n;
+    unsigned ms;
+    Cost g;
+    mutable std::vector<ActionPtr> aa;
 
 public:
-    explicit TracedDomain(const Domain& _d):
+    explicit TracedDomain(const Domain& _d, unsigned _moveState = 0):
         d(_d),
+        last(),
+        n(0),
+        ms(_moveState),
+        g(0),
         aa()
     {
     }
 
-    TracedDomain(const TracedDomain<Domain, ActionPtr>& other,const ActionPtr a):
+    TracedDomain(const TracedDomain<Domain, ActionPtr>& other,const ActionPtr a, unsigned _moveState = 0):
         d(other.d),
-        aa(other.aa)
+        last(other.last),
+        n(other.n),
+        ms(_moveState),
+        g(other.g),
+        aa()
     {
         accept(a);
     }
 
+    /**
+     * @brief State of the move pruning policy the domain was reached in
+     */
+    unsigned moveState() const {
+        return ms;
+    }
+
     void accept(const ActionPtr a) {
         assert((*a).isDefined(d));
+        g += (*a).cost(d);
         d = (*a)(d);
-        aa.push_back(a);
+
+        if(aa.size() == n) {
+            aa.push_back(a);
+        }
+        last = std::make_shared<const Step>(a, last);
+        n++;
     }
 
+    /**
+     * @brief Sum of costs of the actions, each taken when it was accepted
+     */
+    Cost cost() const {
+        return g;
+    }
+
+    /**
+     * @brief Number of actions taken
+     */
+    size_t length() const {
+        return n;
+    }
+
+    /**
+     * @brief Actions in the order taken, laid out from the chain on the first
+     *        call after the domain was reached from another one
+     */
     const std::vector<ActionPtr>& actions() const {
+        if(aa.size() != n) {
+            aa.resize(n);
+            size_t i = n;
+            for(const Step* s = last.get(); s != 0; s = s->before.get()) {
+                aa[--i] = s->action;
+            }
+        }
+
         return aa;
     }
 
@@ -58,7 +126,7 @@ struct ToTracedDomainCostFunctionAdapter: std::unary_function<const TracedDomain
     }
 
     Cost operator()(const TracedDomain<Domain, ActionPtr>& d) const {
-        f(d.domain());
+        return f(d.domain());
     }
 };
 
@@ -70,16 +138,41 @@ struct StepCountCost {
     }
 
     Cost operator ()(const TracedDomain<Domain, ActionPtr>& d) const {
-        return d.actions().size();
+        return d.length();
+    }
+
+};
+
+/**
+ * @brief Cost of the actions of a domain as they price themselves, the
+ *        default step cost of GenericAStar
+ */
+template< typename Domain, typename ActionPtr >
+struct PathCost {
+
+    PathCost()
+    {
+    }
+
+    Cost operator ()(const TracedDomain<Domain, ActionPtr>& d) const {
+        return d.cost();
     }
 
 };
 
 
+/**
+ * Visitor is called on every expanded domain and asked, with its cost, about
+ * every generated one whether it was already visited and can be dropped
+ */
 template<typename Domain>
 struct TreeVisitor {
     void operator()(const Domain& d, std::unordered_set<Domain>& closed_set) {
     }
+
+    bool visited(const Domain& d, Cost g, const std::unordered_set<Domain>& closed_set) {
+        return false;
+    }
 };
 
 template<typename Domain>
@@ -87,6 +180,69 @@ struct GraphVisitor {
     void operator()(const Domain& d, std::unordered_set<Domain>& closed_set) {
         closed_set.insert(d);
     }
+
+    bool visited(const Domain& d, Cost g, const std::unordered_set<Domain>& closed_set) {
+        return closed_set.find(d) != closed_set.end();
+    }
+};
+
+/**
+ * @brief Graph search that gives up after `limit` expansions: from then on
+ *        every generated domain is reported visited and the open set drains
+ */
+template<typename Domain>
+struct BoundedGraphVisitor {
+    size_t limit;
+    size_t* expanded;
+
+    BoundedGraphVisitor(size_t _limit, size_t* _expanded):
+        limit(_limit),
+        expanded(_expanded)
+    {}
+
+    void operator()(const Domain& d, std::unordered_set<Domain>& closed_set) {
+        closed_set.insert(d);
+        (*expanded)++;
+    }
+
+    bool visited(const Domain& d, Cost g, const std::unordered_set<Domain>& closed_set) {
+        return *expanded >= limit || closed_set.find(d) != closed_set.end();
+    }
+};
+
+/**
+ * @brief Tree search that drops domains already reached at no greater cost,
+ *        as recorded in a bounded transposition table keyed by std::hash<Domain>
+ */
+template<typename Domain, typename Table = TranspositionTable<> >
+struct TranspositionVisitor {
+    Table* table;
+
+    TranspositionVisitor(Table* _table):
+        table(_table)
+    {}
+
+    void operator()(const Domain& d, std::unordered_set<Domain>& closed_set) {
+    }
+
+    bool visited(const Domain& d, Cost g, const std::unordered_set<Domain>& closed_set) {
+        return table->prune(std::hash<Domain>()(d), g);
+    }
+};
+
+/**
+ * @brief Move pruning policy of GenericAStar that keeps every action
+ */
+template<typename ActionPtr>
+struct NoMovePruning {
+    unsigned start() const {
+        return 0;
+    }
+
+    bool next(unsigned state, const ActionPtr& a, unsigned& following) const {
+        following = 0;
+        return true;
+    }
 };
 
 template<typename Domain>
@@ -125,7 +281,9 @@ template<
         typename ActionIterator,
         typename GoalTest,
         typename CostFunction,
-        typename StepCostFunction = StepCountCost< Domain, ActionPtr >
+        typename StepCostFunction = PathCost< Domain, ActionPtr >,
+        typename MovePruning = NoMovePruning< ActionPtr >,
+        typename Timeline = NoTimeline
         >
 class GenericAStar: public boost::noncopyable
 {
@@ -212,6 +370,9 @@ private:
     std::unordered_set<Domain> closed_set;
     ActionUniverse<ActionPtr, ActionIterator> universe;
     GoalTest goal;
+    Visitor visitor;
+    MovePruning pruning;
+    Timeline timeline;
 
     void expand(const DomainWithHistory& from, std::queue<  DomainWithHistory >& to) const {
         std::queue<ActionPtr> actionCanBeApplyied;
@@ -220,7 +381,11 @@ private:
         while(!actionCanBeApplyied.empty()) {
             const ActionPtr a = actionCanBeApplyied.front();
             actionCanBeApplyied.pop();
-            to.push(DomainWithHistory(from , a));
+
+            unsigned moveState;
+            if(pruning.next(from.moveState(), a, moveState)) {
+                to.push(DomainWithHistory(from , a, moveState));
+            }
         }
     }
     DomainWithHistory current() {
@@ -239,7 +404,10 @@ public:
             const ActionIterator& actions_end,
             const GoalTest& _goal,
             const CostFunction& _heuristic,
-            const StepCostFunction& _cost = StepCountCost< Domain, ActionPtr >()
+            const StepCostFunction& _cost = StepCostFunction(),
+            const Visitor& _visitor = Visitor(),
+            const MovePruning& _pruning = MovePruning(),
+            const Timeline& _timeline = Timeline()
             ):
         tracedHeuristic(TracedCostFuntction(_heuristic)),
         cost(_cost),
@@ -247,9 +415,12 @@ public:
         open_set(DomainCostCompare(&totalCost)),
         closed_set(),
         universe(actions_begin, actions_end),
-        goal(_goal)
+        goal(_goal),
+        visitor(_visitor),
+        pruning(_pruning),
+        timeline(_timeline)
     {
-        open_set.push(DomainWithHistory(initial));
+        open_set.push(DomainWithHistory(initial, pruning.start()));
     }
 
 
@@ -260,7 +431,10 @@ public:
             const ActionIterator& actions_begin,
             const ActionIterator& actions_end,
             const CostFunction& _heuristic,
-            const StepCostFunction& _cost = StepCountCost<Domain, ActionPtr>()
+            const StepCostFunction& _cost = StepCostFunction(),
+            const Visitor& _visitor = Visitor(),
+            const MovePruning& _pruning = MovePruning(),
+            const Timeline& _timeline = Timeline()
             ):
         tracedHeuristic(_heuristic),
         cost(_cost),
@@ -268,9 +442,12 @@ public:
         open_set(DomainCostCompare(&totalCost)),
         closed_set(),
         universe(actions_begin, actions_end),
-        goal(FinalStateGoal<Domain>(_goal))
+        goal(FinalStateGoal<Domain>(_goal)),
+        visitor(_visitor),
+        pruning(_pruning),
+        timeline(_timeline)
     {
-        open_set.push(TracedDomain<Domain, ActionPtr>(initial));
+        open_set.push(TracedDomain<Domain, ActionPtr>(initial, pruning.start()));
     }
 
 
@@ -284,7 +461,9 @@ template<
         typename ActionItertor,
         typename Goal,
         typename CostFunction,
-        typename StepCostFunction
+        typename StepCostFunction,
+        typename MovePruning,
+        typename Timeline
         >
 bool GenericAStar<Domain,
                   ActionPtr,
@@ -292,14 +471,22 @@ bool GenericAStar<Domain,
                   ActionItertor,
                   Goal,
                   CostFunction,
-                  StepCostFunction
+                  StepCostFunction,
+                  MovePruning,
+                  Timeline
                  >::plan(DomainWithHistory &domainWithActionsApplyied) {
 
     DomainWithHistory cur = current();
-    Visitor visitor;
+    visitor.visited(cur.domain(), cost(cur), closed_set);
 
+    size_t expanded = 0;
     while (! goal(cur.domain())) {
 
+        if(timeline.due()) {
+            timeline.sample(open_set.size(), closed_set.size(), totalCost(cur), expanded);
+        }
+        expanded++;
+
         visitor(cur.domain(), closed_set);
 
         std::queue<DomainWithHistory> reachable;
@@ -309,7 +496,7 @@ bool GenericAStar<Domain,
         while (!reachable.empty()) {
 
             DomainWithHistory& r  = reachable.front();
-            if(closed_set.find(r.domain())==closed_set.end()){
+            if(!visitor.visited(r.domain(), cost(r), closed_set)){
                 open_set.push(reachable.front());
             }
             reachable.pop();
@@ -348,6 +535,37 @@ bool tree_plan(
     return planner.plan(history);
 }
 
+/**
+ * @brief Tree search pruned by `table`, which later searches may reuse: each
+ *        starts a new search on it and ignores entries of earlier ones
+ */
+template <typename Domain, typename ActionPtr, typename ActionsIterator, typename CostFunction, typename Table>
+bool tree_plan(
+        const Domain& initial,
+        const Domain& final,
+        const CostFunction heuristic,
+        const ActionsIterator actionsBegin,
+        const ActionsIterator actionsEnd,
+        Table& table,
+        TracedDomain<Domain, ActionPtr>& history
+        ) {
+
+    table.newSearch();
+
+    GenericAStar<
+            Domain,
+            ActionPtr,
+            TranspositionVisitor<Domain, Table>,
+            ActionsIterator,
+            FinalStateGoal<Domain>,
+            CostFunction
+            >
+            planner(initial, final, actionsBegin, actionsEnd, heuristic,
+                    PathCost<Domain, ActionPtr>(), TranspositionVisitor<Domain, Table>(&table));
+
+    return planner.plan(history);
+}
+
 template <typename Domain, typename ActionPtr, typename ActionsIterator, typename CostFunction>
 bool graph_plan(
         const Domain& initial,
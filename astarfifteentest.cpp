@@ -1,32 +1,19 @@
 #include "astar.h"
 #include "model.h"
 #include "actions.h"
+#include "manhattan.h"
+#include "movepruning.h"
+#include "staged.h"
+#include "heuristiccache.h"
+#include "fringe.h"
+#include "generator.h"
+#include "testfields.h"
+#include <queue>
+#include <sstream>
+#include <unordered_map>
 #include <boost/optional.hpp>
 #include <gtest/gtest.h>
 
-struct AllActionsAtThisPosition {
-    std::vector<FifteenAction*>* actions;
-
-    void operator()(const Place& p){
-        MoveDown* d = new MoveDown(p.position);
-        MoveUp* u = new MoveUp(p.position);
-        MoveLeft* l = new MoveLeft(p.position);
-        MoveRight* r = new MoveRight(p.position);
-
-        actions->push_back(l);
-        actions->push_back(r);
-        actions->push_back(u);
-        actions->push_back(d);
-    }
-};
-
-void allPossibleActions(const Field& f, std::vector<FifteenAction*>& actions) {
-    AllActionsAtThisPosition actionsFunctor;
-    actionsFunctor.actions = &actions;
-
-    std::for_each(f.begin(), f.end(), actionsFunctor);
-}
-
 struct AtRightPlace{
 
     int size;
@@ -102,23 +89,6 @@ struct MovemetsToRightPlaceHeuristic: std::unary_function<const Field&, Cost> {
  *
  *8 1 7 4 5 6 2 0 3
  */
-Field testField() {
-    std::vector<Place> p;
-
-
-    p.push_back(Place(Position(0,0), Tile(8)));
-    p.push_back(Place(Position(0,1), Tile(1)));
-    p.push_back(Place(Position(0,2), Tile(7)));
-    p.push_back(Place(Position(1,0), Tile(4)));
-    p.push_back(Place(Position(1,1), Tile(5)));
-    p.push_back(Place(Position(1,2), Tile(6)));
-    p.push_back(Place(Position(2,0), Tile(2)));
-    p.push_back(Place(Position(2,1)));//, Tile(2)));
-    p.push_back(Place(Position(2,2), Tile(3)));
-
-    return Field(p);
-}
-
 void printActionAndTileField(FifteenAction* a) {
     static Field field = testField();
     a->print(std::cout);
@@ -182,6 +152,412 @@ TEST(AStar, shouldFindAsolutionAsAGraph) {
     EXPECT_TRUE(true);
 }
 
+TEST(AStar, shouldFindTheSameSolutionWithPackedHeuristic) {
+
+    std::vector<FifteenAction*> actions;
+
+    Field f = testField();
+    TracedDomain<Field, FifteenAction*> solution(f);
+    TracedDomain<Field, FifteenAction*> packedSolution(f);
+
+    allPossibleActions(f, actions);
+
+    graph_plan(testField(), Field(3), MovemetsToRightPlaceHeuristic(), actions.begin(), actions.end(), solution);
+    graph_plan(testField(), Field(3), PackedManhattanHeuristic(), actions.begin(), actions.end(), packedSolution);
+
+    EXPECT_TRUE(packedSolution.domain() == Field(3));
+    EXPECT_EQ(packedSolution.actions().size(), solution.actions().size());
+}
+
+TEST(TranspositionTable, shouldKeepBestCost) {
+    TranspositionTable<> table(1 << 16);
+    Cost g;
+
+    EXPECT_LE(table.bytes(), 1u << 16);
+    EXPECT_FALSE(table.probe(42, g));
+
+    EXPECT_FALSE(table.prune(42, 7));
+    EXPECT_TRUE(table.probe(42, g));
+    EXPECT_EQ(g, 7);
+
+    EXPECT_TRUE(table.prune(42, 7));
+    EXPECT_TRUE(table.prune(42, 9));
+    EXPECT_FALSE(table.prune(42, 5));
+    EXPECT_TRUE(table.probe(42, g));
+    EXPECT_EQ(g, 5);
+}
+
+TEST(TranspositionTable, shouldReplaceOlderThenDeeperEntries) {
+    TranspositionTable<2> table(2*2*16);
+    Cost g;
+
+    ASSERT_EQ(table.capacity(), 4u);
+
+    // 0, 2, 4 and 6 share the bucket
+    table.store(0, 1);
+    table.newSearch();
+    table.store(2, 5);
+    table.store(4, 3);
+
+    EXPECT_FALSE(table.probe(0, g));
+    EXPECT_TRUE(table.probe(2, g));
+
+    table.store(6, 4);
+
+    EXPECT_FALSE(table.probe(2, g));
+    EXPECT_TRUE(table.probe(4, g));
+    EXPECT_TRUE(table.probe(6, g));
+}
+
+/**
+ * @brief MovemetsToRightPlaceHeuristic counting its evaluations
+ */
+struct CountedHeuristic: std::unary_function<const Field&, Cost> {
+    size_t* evaluations;
+
+    CountedHeuristic(size_t* _evaluations):
+        evaluations(_evaluations)
+    {}
+
+    Cost operator()(const Field& f) const {
+        (*evaluations)++;
+        return MovemetsToRightPlaceHeuristic()(f);
+    }
+};
+
+TEST(HeuristicCache, shouldNeverReturnAnotherDomainsValue) {
+    HeuristicCache<Field, 1> cache(1);
+    EXPECT_EQ(cache.capacity(), 1u);
+    EXPECT_EQ((HeuristicCache<Field, 2>(7).capacity()), 4u);
+    EXPECT_EQ((HeuristicCache<Field, 2>(2).capacity()), 2u);
+
+    std::vector<FifteenAction*> actions;
+    Field f = testField();
+    allPossibleActions(f, actions);
+
+    size_t evaluations = 0;
+    CachedHeuristic<CountedHeuristic, HeuristicCache<Field, 1> > cached(&cache, CountedHeuristic(&evaluations));
+
+    for(unsigned i = 0; i < 200; i++) {
+        EXPECT_EQ(cached(f), MovemetsToRightPlaceHeuristic()(f));
+        EXPECT_EQ(cached(f), MovemetsToRightPlaceHeuristic()(f));
+
+        std::vector<FifteenAction*> applicable;
+        for(size_t a = 0; a < actions.size(); a++) {
+            if(actions[a]->isDefined(f)) {
+                applicable.push_back(actions[a]);
+            }
+        }
+        f = (*applicable[i % applicable.size()])(f);
+    }
+
+    EXPECT_EQ(cache.hits() + cache.misses(), 400u);
+    EXPECT_EQ(evaluations, cache.misses());
+    EXPECT_GE(cache.hits(), 200u);
+}
+
+TEST(HeuristicCache, shouldSaveEvaluationsOfAGraphSearch) {
+    std::vector<FifteenAction*> actions;
+
+    Field f = testField();
+    allPossibleActions(f, actions);
+
+    size_t plainEvaluations = 0;
+    TracedDomain<Field, FifteenAction*> plain(f);
+    ASSERT_TRUE(graph_plan(f, Field(3), CountedHeuristic(&plainEvaluations), actions.begin(), actions.end(), plain));
+
+    size_t cachedEvaluations = 0;
+    HeuristicCache<Field> cache(1 << 14);
+    TracedDomain<Field, FifteenAction*> cached(f);
+    ASSERT_TRUE(graph_plan(f, Field(3), CachedHeuristic<CountedHeuristic>(&cache, CountedHeuristic(&cachedEvaluations)),
+                           actions.begin(), actions.end(), cached));
+
+    EXPECT_EQ(cached.actions().size(), plain.actions().size());
+    EXPECT_EQ(cachedEvaluations, cache.misses());
+    EXPECT_EQ(cache.hits() + cache.misses(), plainEvaluations);
+    EXPECT_LT(10*cachedEvaluations, plainEvaluations);
+}
+
+TEST(SearchTimeline, shouldSampleGraphSearchesAndWriteThem) {
+    std::vector<FifteenAction*> actions;
+
+    Field f = testField();
+    allPossibleActions(f, actions);
+
+    SearchTimeline timeline(0, 16);
+
+    GenericAStar<
+            Field,
+            FifteenAction*,
+            GraphVisitor<Field>,
+            std::vector<FifteenAction*>::iterator,
+            FinalStateGoal<Field>,
+            MovemetsToRightPlaceHeuristic,
+            PathCost<Field, FifteenAction*>,
+            NoMovePruning<FifteenAction*>,
+            TimelineSampler
+            >
+            planner(f, Field(3), actions.begin(), actions.end(), MovemetsToRightPlaceHeuristic(),
+                    PathCost<Field, FifteenAction*>(), GraphVisitor<Field>(), NoMovePruning<FifteenAction*>(), TimelineSampler(&timeline));
+
+    TracedDomain<Field, FifteenAction*> solution(f);
+    ASSERT_TRUE(planner.plan(solution));
+
+    const std::vector<SearchTimeline::Sample>& samples = timeline.samples();
+    ASSERT_GT(samples.size(), 2u);
+    EXPECT_EQ(samples[0].expanded, 0u);
+    for(size_t i = 1; i < samples.size(); i++) {
+        EXPECT_EQ(samples[i].expanded, samples[i-1].expanded + 16);
+        EXPECT_LE(samples[i].closed, samples[i].expanded);
+        EXPECT_GE(samples[i].seconds, samples[i-1].seconds);
+        EXPECT_LE(samples[i].f, Cost(solution.actions().size()));
+        EXPECT_GT(samples[i].residentBytes, 0u);
+    }
+
+    std::ostringstream csv;
+    timeline.writeCsv(csv);
+    const std::string lines = csv.str();
+    EXPECT_EQ(size_t(std::count(lines.begin(), lines.end(), '\n')), samples.size() + 1);
+
+    std::ostringstream trace;
+    timeline.writeChromeTrace(trace);
+    const std::string events = trace.str();
+    EXPECT_EQ(events.find("{\"traceEvents\":["), 0u);
+    EXPECT_NE(events.find("\"expansions/s\""), std::string::npos);
+
+    timeline.restart();
+    EXPECT_TRUE(timeline.samples().empty());
+}
+
+TEST(AStar, shouldFindAsolutionAsATreeWithTranspositionTable) {
+
+    std::vector<FifteenAction*> actions;
+
+    Field f = testField();
+    TracedDomain<Field, FifteenAction*> solution(f);
+    TracedDomain<Field, FifteenAction*> graphSolution(f);
+
+    allPossibleActions(f, actions);
+
+    TranspositionTable<> table(1 << 20);
+
+    EXPECT_TRUE(tree_plan(testField(), Field(3), MovemetsToRightPlaceHeuristic(), actions.begin(), actions.end(), table, solution));
+    graph_plan(testField(), Field(3), MovemetsToRightPlaceHeuristic(), actions.begin(), actions.end(), graphSolution);
+
+    EXPECT_TRUE(solution.domain() == Field(3));
+    EXPECT_EQ(solution.actions().size(), graphSolution.actions().size());
+}
+
+TEST(AStar, shouldStayOptimalWithATableSharedBySearches) {
+    TranspositionTable<> table(1 << 20);
+    InstanceGenerator generator(3, 29);
+
+    for(unsigned i = 0; i < 12; i++) {
+        std::vector<FifteenAction*> actions;
+
+        Field f = generator.shuffled(40);
+        TracedDomain<Field, FifteenAction*> solution(f);
+        TracedDomain<Field, FifteenAction*> graphSolution(f);
+
+        allPossibleActions(f, actions);
+
+        ASSERT_TRUE(tree_plan(f, Field(3), MovemetsToRightPlaceHeuristic(), actions.begin(), actions.end(), table, solution));
+        ASSERT_TRUE(graph_plan(f, Field(3), MovemetsToRightPlaceHeuristic(), actions.begin(), actions.end(), graphSolution));
+
+        EXPECT_TRUE(solution.domain() == Field(3));
+        EXPECT_EQ(solution.actions().size(), graphSolution.actions().size());
+    }
+}
+
+TEST(MoveAutomaton, shouldForbidInversesAndLongerRotations) {
+    MoveAutomaton automaton(6);
+
+    std::vector<Direction> upDown;
+    upDown.push_back(Up);
+    upDown.push_back(Down);
+    EXPECT_FALSE(automaton.accepts(upDown));
+
+    Direction larger[] = {Left, Up, Right, Down, Left, Up};
+    Direction smaller[] = {Up, Left, Down, Right, Up, Left};
+    EXPECT_FALSE(automaton.accepts(std::vector<Direction>(larger, larger+6)));
+    EXPECT_TRUE(automaton.accepts(std::vector<Direction>(smaller, smaller+6)));
+
+    EXPECT_EQ(automaton.forbiddenSequences(), 8u);
+}
+
+/**
+ * BFS over (field, automaton state) pairs has to reach every 8-puzzle field
+ * as soon as the plain one does
+ */
+TEST(MoveAutomaton, shouldKeepAnOptimalPathToEveryEightPuzzle) {
+    MoveAutomaton automaton(6);
+
+    std::unordered_map<PackedField, unsigned> plain;
+    std::unordered_map<PackedField, unsigned> pruned;
+    std::unordered_set<uint64_t> seenPairs;
+
+    std::queue< std::pair<PackedField, unsigned> > frontier;
+    frontier.push(std::make_pair(packedGoal(3), 0u));
+    plain[packedGoal(3)] = 0;
+
+    while(!frontier.empty()) {
+        PackedField p = frontier.front().first;
+        unsigned d = frontier.front().second;
+        frontier.pop();
+
+        unsigned blank = blankAt(p, 3);
+        for(unsigned dir = Up; dir <= Right; dir++) {
+            unsigned to = neighbour(blank, static_cast<Direction>(dir), 3);
+            if(to < 9 && plain.insert(std::make_pair(slide(p, blank, to), d+1)).second) {
+                frontier.push(std::make_pair(slide(p, blank, to), d+1));
+            }
+        }
+    }
+
+    std::queue< std::pair<PackedField, unsigned> > pairs;
+    pairs.push(std::make_pair(packedGoal(3), unsigned(MoveAutomaton::Start)));
+    pruned[packedGoal(3)] = 0;
+
+    for(unsigned depth = 0; !pairs.empty(); depth++) {
+        std::queue< std::pair<PackedField, unsigned> > next;
+
+        while(!pairs.empty()) {
+            PackedField p = pairs.front().first;
+            unsigned state = pairs.front().second;
+            pairs.pop();
+
+            unsigned blank = blankAt(p, 3);
+            for(unsigned dir = Up; dir <= Right; dir++) {
+                unsigned to = neighbour(blank, static_cast<Direction>(dir), 3);
+                int following = automaton.next(state, static_cast<Direction>(dir));
+                if(to >= 9 || following == MoveAutomaton::Pruned) {
+                    continue;
+                }
+
+                PackedField n = slide(p, blank, to);
+                pruned.insert(std::make_pair(n, depth+1));
+                if(seenPairs.insert((n << 16) | unsigned(following)).second) {
+                    next.push(std::make_pair(n, unsigned(following)));
+                }
+            }
+        }
+
+        pairs.swap(next);
+    }
+
+    ASSERT_EQ(pruned.size(), plain.size());
+    for(std::unordered_map<PackedField, unsigned>::const_iterator it = plain.begin(); it != plain.end(); ++it) {
+        ASSERT_EQ(pruned[it->first], it->second);
+    }
+}
+
+TEST(AStar, shouldFindAsolutionAsATreeWithMovePruning) {
+
+    std::vector<FifteenAction*> actions;
+
+    Field f = testField();
+    TracedDomain<Field, FifteenAction*> solution(f);
+    TracedDomain<Field, FifteenAction*> graphSolution(f);
+
+    allPossibleActions(f, actions);
+
+    MoveAutomaton automaton(8);
+
+    EXPECT_TRUE(pruned_tree_plan(testField(), Field(3), MovemetsToRightPlaceHeuristic(), actions.begin(), actions.end(), automaton, solution));
+    graph_plan(testField(), Field(3), MovemetsToRightPlaceHeuristic(), actions.begin(), actions.end(), graphSolution);
+
+    EXPECT_TRUE(solution.domain() == Field(3));
+    EXPECT_EQ(solution.actions().size(), graphSolution.actions().size());
+}
+
+
+TEST(StagedSolver, shouldSolveSmallFieldsOptimally) {
+
+    std::vector<FifteenAction*> actions;
+
+    Field f = testField();
+    TracedDomain<Field, FifteenAction*> solution(f);
+    TracedDomain<Field, FifteenAction*> staged(f);
+
+    allPossibleActions(f, actions);
+
+    graph_plan(testField(), Field(3), MovemetsToRightPlaceHeuristic(), actions.begin(), actions.end(), solution);
+    ASSERT_TRUE(staged_plan(f, actions.begin(), actions.end(), staged));
+
+    EXPECT_TRUE(staged.domain() == Field(3));
+    EXPECT_EQ(staged.actions().size(), solution.actions().size());
+}
+
+TEST(StagedSolver, shouldSolveLargeFields) {
+    for(unsigned size = 4; size <= 7; size++) {
+        std::vector<FifteenAction*> actions;
+
+        Field f = InstanceGenerator(size, 35).shuffled(20000);
+        TracedDomain<Field, FifteenAction*> history(f);
+
+        allPossibleActions(f, actions);
+
+        StagedSolver<FifteenAction*> solver;
+        ASSERT_TRUE(solver.solve(actions.begin(), actions.end(), history));
+
+        EXPECT_TRUE(history.domain() == Field(size));
+        EXPECT_EQ(solver.moves(), history.actions().size());
+        // a stage per tile outside the final 3x3 but one for the last two of
+        // each of the 2*(size-3) lines, and one for the final 3x3
+        EXPECT_EQ(solver.stages().size(), size*size - 9 - 2*(size-3) + 1);
+    }
+}
+
+TEST(FringeSearch, shouldFindOptimalSolutions) {
+    InstanceGenerator generator(3, 45);
+
+    for(unsigned i = 0; i < 6; i++) {
+        std::vector<FifteenAction*> actions;
+
+        Field f = i == 0 ? testField() : generator.shuffled(300);
+        allPossibleActions(f, actions);
+
+        TracedDomain<Field, FifteenAction*> reference(f);
+        ASSERT_TRUE(graph_plan(f, Field(3), PackedManhattanHeuristic(), actions.begin(), actions.end(), reference));
+
+        FringeSearch<
+                Field,
+                FifteenAction*,
+                std::vector<FifteenAction*>::iterator,
+                FinalStateGoal<Field>,
+                PackedManhattanHeuristic
+                >
+                fringe(f, actions.begin(), actions.end(), FinalStateGoal<Field>(Field(3)), PackedManhattanHeuristic());
+
+        TracedDomain<Field, FifteenAction*> solution(f);
+        ASSERT_TRUE(fringe.plan(solution));
+
+        EXPECT_TRUE(solution.domain() == Field(3));
+        EXPECT_EQ(solution.actions().size(), reference.actions().size());
+        EXPECT_EQ(solution.cost(), reference.cost());
+        EXPECT_LE(fringe.cached(), 181440u);
+        EXPECT_GE(fringe.iterations(), 1u);
+    }
+}
+
+TEST(FringeSearch, shouldFindCheapestSolutionsWithWeightedActions) {
+    std::vector<FifteenAction*> actions;
+    std::vector<FifteenAction*> weighted;
+
+    Field f = InstanceGenerator(3, 46).shuffled(40);
+    allPossibleActions(f, actions);
+    for(size_t a = 0; a < actions.size(); a++) {
+        weighted.push_back(new TileWeightedAction(actions[a]));
+    }
+
+    TracedDomain<Field, FifteenAction*> reference(f);
+    TracedDomain<Field, FifteenAction*> solution(f);
+    ASSERT_TRUE(graph_plan(f, Field(3), PackedManhattanHeuristic(), weighted.begin(), weighted.end(), reference));
+    ASSERT_TRUE(fringe_plan(f, Field(3), PackedManhattanHeuristic(), weighted.begin(), weighted.end(), solution));
+
+    EXPECT_TRUE(solution.domain() == Field(3));
+    EXPECT_EQ(solution.cost(), reference.cost());
+}
 
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
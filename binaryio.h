@@ -0,0 +1,307 @@
+#ifndef BINARYIO_H
+#define BINARYIO_H
+
+#include "model.h"
+#include "packed.h"
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <ostream>
+#include <boost/utility.hpp>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * Binary batch format:
+ *   header:  "FIFB", version (1 byte), field size (1 byte), 2 zero bytes
+ *   records: field, fixed width: tile of every place (0 for the vacant one)
+ *            in ceil(log2(size*size)) bits, little endian bit order, so
+ *            3x3 and 4x4 fields are exactly their PackedField;
+ *            number of moves (2 bytes, little endian);
+ *            moves of the vacant place, 2 bits each (Direction), 4 per byte
+ */
+namespace binary {
+
+enum {
+    Version = 1,
+    HeaderBytes = 8
+};
+
+inline unsigned cellBits(unsigned size) {
+    unsigned bits = 1;
+    while((1u << bits) < size*size) {
+        bits++;
+    }
+
+    return bits;
+}
+
+inline size_t fieldBytes(unsigned size) {
+    return (size*size*cellBits(size) + 7)/8;
+}
+
+inline size_t movesBytes(size_t moves) {
+    return (moves + 3)/4;
+}
+
+inline void encodeField(const std::vector<unsigned>& tiles, unsigned size, uint8_t* out) {
+    const unsigned bits = cellBits(size);
+    memset(out, 0, fieldBytes(size));
+
+    for(unsigned cell = 0; cell < size*size; cell++) {
+        for(unsigned b = 0; b < bits; b++) {
+            if((tiles[cell] >> b) & 1) {
+                unsigned at = cell*bits+b;
+                out[at/8] |= 1 << (at%8);
+            }
+        }
+    }
+}
+
+inline unsigned decodeTile(const uint8_t* in, unsigned size, unsigned cell) {
+    const unsigned bits = cellBits(size);
+
+    unsigned tile = 0;
+    for(unsigned b = 0; b < bits; b++) {
+        unsigned at = cell*bits+b;
+        tile |= ((in[at/8] >> (at%8)) & 1) << b;
+    }
+
+    return tile;
+}
+
+inline std::vector<unsigned> tiles(const Field& f) {
+    std::vector<unsigned> t;
+    for(Field::const_iterator it = f.begin(); it != f.end(); ++it) {
+        t.push_back(it->tileMaybe.get_value_or(Tile(0)).value);
+    }
+
+    return t;
+}
+
+}
+
+/**
+ * @brief Streams records in the binary batch format
+ */
+class BinaryWriter: public boost::noncopyable
+{
+    std::ostream& os;
+    const unsigned size;
+    std::vector<uint8_t> buffer;
+
+public:
+    BinaryWriter(std::ostream& _os, unsigned _size):
+        os(_os),
+        size(_size),
+        buffer()
+    {
+        const char header[binary::HeaderBytes] = {'F', 'I', 'F', 'B', binary::Version, char(size), 0, 0};
+        os.write(header, binary::HeaderBytes);
+    }
+
+    void write(const std::vector<unsigned>& tiles, const std::vector<Direction>& moves) {
+        assert(tiles.size() == size*size);
+        assert(moves.size() <= 0xFFFF);
+
+        const size_t fieldBytes = binary::fieldBytes(size);
+        buffer.assign(fieldBytes + 2 + binary::movesBytes(moves.size()), 0);
+
+        binary::encodeField(tiles, size, &buffer[0]);
+        buffer[fieldBytes] = moves.size() & 0xFF;
+        buffer[fieldBytes+1] = moves.size() >> 8;
+
+        for(size_t i = 0; i < moves.size(); i++) {
+            buffer[fieldBytes + 2 + i/4] |= moves[i] << (2*(i%4));
+        }
+
+        os.write(reinterpret_cast<const char*>(&buffer[0]), buffer.size());
+    }
+
+    void write(const Field& f, const std::vector<Direction>& moves = std::vector<Direction>()) {
+        assert(f.size == size);
+        write(binary::tiles(f), moves);
+    }
+
+    void write(PackedField p, const std::vector<Direction>& moves = std::vector<Direction>()) {
+        std::vector<unsigned> tiles(size*size);
+        for(unsigned cell = 0; cell < size*size; cell++) {
+            tiles[cell] = tileAt(p, cell);
+        }
+
+        write(tiles, moves);
+    }
+
+    bool good() const {
+        return os.good();
+    }
+};
+
+/**
+ * @brief One record, pointing into the buffer it was read from
+ */
+struct BinaryRecord {
+    unsigned size;
+    const uint8_t* field;
+    size_t moves;
+    const uint8_t* directions;
+
+    unsigned tile(unsigned cell) const {
+        return binary::decodeTile(field, size, cell);
+    }
+
+    /**
+     * @brief With 4 bits per place (3x3 and 4x4) the record already is the
+     *        PackedField, smaller fields are decoded place by place
+     */
+    PackedField packed() const {
+        assert(size <= MaxPackedSize);
+
+        PackedField p = 0;
+        if(binary::cellBits(size) == 4) {
+            memcpy(&p, field, binary::fieldBytes(size));
+            return p;
+        }
+
+        for(unsigned cell = 0; cell < size*size; cell++) {
+            p = withTile(p, cell, tile(cell));
+        }
+        return p;
+    }
+
+    Field domain() const {
+        std::vector<Place> places;
+        for(unsigned cell = 0; cell < size*size; cell++) {
+            Position pos(cell/size, cell%size);
+            if(tile(cell) == 0) {
+                places.push_back(Place(pos));
+            } else {
+                places.push_back(Place(pos, Tile(tile(cell))));
+            }
+        }
+
+        return Field(places);
+    }
+
+    Direction move(size_t i) const {
+        assert(i < moves);
+        return static_cast<Direction>((directions[i/4] >> (2*(i%4))) & 3);
+    }
+};
+
+/**
+ * @brief Iterates records of a binary batch held in memory, without copying
+ */
+class BinaryReader {
+    const uint8_t* data;
+    size_t length;
+    size_t offset;
+    unsigned fieldSize;
+
+public:
+    BinaryReader(const void* _data, size_t _length):
+        data(static_cast<const uint8_t*>(_data)),
+        length(_length),
+        offset(binary::HeaderBytes),
+        fieldSize(0)
+    {
+        if(length >= binary::HeaderBytes && memcmp(data, "FIFB", 4) == 0 && data[4] == binary::Version) {
+            fieldSize = data[5];
+        }
+    }
+
+    /**
+     * @brief False if the buffer does not start with a known header
+     */
+    bool valid() const {
+        return fieldSize != 0;
+    }
+
+    unsigned size() const {
+        return fieldSize;
+    }
+
+    /**
+     * @brief False at the end of the buffer or on a truncated record
+     */
+    bool next(BinaryRecord& record) {
+        if(!valid()) {
+            return false;
+        }
+
+        const size_t fieldBytes = binary::fieldBytes(fieldSize);
+        if(offset + fieldBytes + 2 > length) {
+            return false;
+        }
+
+        record.size = fieldSize;
+        record.field = data + offset;
+        record.moves = data[offset+fieldBytes] | (data[offset+fieldBytes+1] << 8);
+        record.directions = data + offset + fieldBytes + 2;
+
+        size_t next = offset + fieldBytes + 2 + binary::movesBytes(record.moves);
+        if(next > length) {
+            return false;
+        }
+
+        offset = next;
+        return true;
+    }
+};
+
+/**
+ * @brief Read-only memory mapping of a whole file
+ */
+class MappedFile: public boost::noncopyable
+{
+    void* address;
+    size_t length;
+
+public:
+    explicit MappedFile(const char* path):
+        address(MAP_FAILED),
+        length(0)
+    {
+        int fd = open(path, O_RDONLY);
+        if(fd < 0) {
+            return;
+        }
+
+        struct stat st;
+        if(fstat(fd, &st) == 0 && st.st_size > 0) {
+            length = st.st_size;
+            address = mmap(0, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(address != MAP_FAILED) {
+                madvise(address, length, MADV_SEQUENTIAL);
+            }
+        }
+
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if(address != MAP_FAILED) {
+            munmap(address, length);
+        }
+    }
+
+    bool mapped() const {
+        return address != MAP_FAILED;
+    }
+
+    const void* data() const {
+        return address;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+    BinaryReader reader() const {
+        return mapped() ? BinaryReader(address, length) : BinaryReader(0, 0);
+    }
+};
+
+#endif // BINARYIO_H
@@ -0,0 +1,132 @@
+#include "model.h"
+#include "packed.h"
+#include "binaryio.h"
+#include "testfields.h"
+#include <gtest/gtest.h>
+#include <fstream>
+#include <sstream>
+#include <stdlib.h>
+
+std::vector<Direction> randomMoves(size_t count) {
+    std::vector<Direction> moves;
+    for(size_t i = 0; i < count; i++) {
+        moves.push_back(static_cast<Direction>(rand()%4));
+    }
+
+    return moves;
+}
+
+TEST(BinaryIO, shouldPackFieldsUpToFourByFourIntoEightBytes) {
+    EXPECT_EQ(binary::fieldBytes(3), 5u);
+    EXPECT_EQ(binary::fieldBytes(4), 8u);
+    EXPECT_EQ(binary::fieldBytes(5), 16u);
+
+    std::ostringstream os;
+    BinaryWriter writer(os, 4);
+    writer.write(Field(4));
+
+    std::string bytes = os.str();
+    ASSERT_EQ(bytes.size(), binary::HeaderBytes + 8 + 2);
+
+    PackedField p;
+    memcpy(&p, bytes.data() + binary::HeaderBytes, 8);
+    EXPECT_EQ(p, packedGoal(4));
+}
+
+TEST(BinaryIO, shouldReadBackThroughMappedFile) {
+    srand(32);
+
+    const char* path = "binaryio_test.bin";
+    std::vector<PackedField> fields;
+    std::vector< std::vector<Direction> > solutions;
+
+    {
+        std::ofstream out(path, std::ios::binary);
+        BinaryWriter writer(out, 4);
+
+        for(unsigned i = 0; i < 100; i++) {
+            fields.push_back(randomWalk(4, 100));
+            solutions.push_back(randomMoves(i % 13));
+            writer.write(fields.back(), solutions.back());
+        }
+
+        ASSERT_TRUE(writer.good());
+    }
+
+    MappedFile file(path);
+    ASSERT_TRUE(file.mapped());
+
+    BinaryReader reader = file.reader();
+    ASSERT_TRUE(reader.valid());
+    EXPECT_EQ(reader.size(), 4u);
+
+    BinaryRecord record;
+    for(unsigned i = 0; i < fields.size(); i++) {
+        ASSERT_TRUE(reader.next(record));
+        EXPECT_EQ(record.packed(), fields[i]);
+        EXPECT_TRUE(record.domain() == unpack(fields[i], 4));
+        ASSERT_EQ(record.moves, solutions[i].size());
+        for(size_t m = 0; m < record.moves; m++) {
+            EXPECT_EQ(record.move(m), solutions[i][m]);
+        }
+    }
+    EXPECT_FALSE(reader.next(record));
+
+    remove(path);
+    EXPECT_FALSE(MappedFile(path).mapped());
+}
+
+TEST(BinaryIO, shouldRoundTripSmallFields) {
+    srand(33);
+
+    for(unsigned size = 2; size <= 3; size++) {
+        std::vector<PackedField> fields;
+
+        std::ostringstream os;
+        BinaryWriter writer(os, size);
+        for(unsigned i = 0; i < 50; i++) {
+            fields.push_back(i == 0 ? packedGoal(size) : randomWalk(size, 100));
+            writer.write(fields.back(), randomMoves(i % 5));
+        }
+
+        std::string bytes = os.str();
+        BinaryReader reader(bytes.data(), bytes.size());
+        ASSERT_TRUE(reader.valid());
+        EXPECT_EQ(reader.size(), size);
+
+        BinaryRecord record;
+        for(unsigned i = 0; i < fields.size(); i++) {
+            ASSERT_TRUE(reader.next(record));
+            EXPECT_EQ(record.packed(), fields[i]);
+            EXPECT_TRUE(record.domain() == unpack(fields[i], size));
+        }
+        EXPECT_FALSE(reader.next(record));
+    }
+}
+
+TEST(BinaryIO, shouldHandleLargeFieldsAndBrokenInput) {
+    Field f(5);
+
+    std::ostringstream os;
+    BinaryWriter writer(os, 5);
+    writer.write(f, randomMoves(7));
+
+    std::string bytes = os.str();
+
+    BinaryReader reader(bytes.data(), bytes.size());
+    BinaryRecord record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_TRUE(record.domain() == f);
+    EXPECT_EQ(record.moves, 7u);
+
+    BinaryReader truncated(bytes.data(), bytes.size()-1);
+    EXPECT_FALSE(truncated.next(record));
+
+    bytes[0] = 'X';
+    EXPECT_FALSE(BinaryReader(bytes.data(), bytes.size()).valid());
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
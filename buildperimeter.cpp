@@ -0,0 +1,32 @@
+#include "perimeter.h"
+#include <iostream>
+#include <stdlib.h>
+
+int main(int argc, char** argv) {
+    if(argc != 4) {
+        std::cerr<<"usage: "<<argv[0]<<" <size> <depth> <perimeter file>"<<std::endl;
+        return 1;
+    }
+
+    unsigned size = atoi(argv[1]);
+    if(size < 2 || size > MaxPackedSize) {
+        std::cerr<<"size must be 2 to "<<MaxPackedSize<<std::endl;
+        return 1;
+    }
+
+    int depth = atoi(argv[2]);
+    if(depth < 0 || depth > 80) {
+        std::cerr<<"depth must be 0 to 80"<<std::endl;
+        return 1;
+    }
+
+    Perimeter perimeter(size, depth);
+
+    if(!perimeter.save(argv[3])) {
+        std::cerr<<"could not write "<<argv[3]<<std::endl;
+        return 1;
+    }
+
+    std::cout<<perimeter.fields()<<" fields within "<<perimeter.depth()<<" moves, written to "<<argv[3]<<std::endl;
+    return 0;
+}
@@ -0,0 +1,381 @@
+#ifndef CLOSEDSET_H
+#define CLOSEDSET_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <algorithm>
+#include <boost/utility.hpp>
+
+/**
+ * @brief Packed state of boards up to 5x5 (5 bits per place), 0 is never a
+ *        valid state and marks free slots
+ */
+struct PackedKey128 {
+    uint64_t lo;
+    uint64_t hi;
+
+    bool operator == (const PackedKey128& other) const {
+        return lo == other.lo && hi == other.hi;
+    }
+
+    bool operator != (const PackedKey128& other) const {
+        return !(*this == other);
+    }
+};
+
+template<typename Key>
+struct ClosedSetKey;
+
+template<>
+struct ClosedSetKey<uint64_t> {
+    static bool free(uint64_t key) {
+        return key == 0;
+    }
+
+    static size_t hash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ULL;
+        key ^= key >> 33;
+
+        return key;
+    }
+};
+
+template<>
+struct ClosedSetKey<PackedKey128> {
+    static bool free(const PackedKey128& key) {
+        return key.lo == 0 && key.hi == 0;
+    }
+
+    static size_t hash(const PackedKey128& key) {
+        return ClosedSetKey<uint64_t>::hash(key.lo ^ ClosedSetKey<uint64_t>::hash(key.hi + 0x9e3779b97f4a7c15ULL));
+    }
+};
+
+/**
+ * @brief Robin Hood open addressing map from packed states to a small value
+ *        (best g, node id), stored inline.
+ *
+ * Growing does not rehash at once: the table being outgrown is kept and at
+ * most `migrationStep` of its slots are moved to the new one on every insert,
+ * lookups consult the new table first. Slot arrays come zeroed from calloc,
+ * so allocating a large one does not touch its memory either.
+ */
+template<typename Key = uint64_t, typename Value = uint32_t>
+class ClosedSet: public boost::noncopyable
+{
+    struct Slot {
+        Key key;
+        Value value;
+        uint32_t distance;
+    };
+
+    struct Table {
+        Slot* slots;
+        size_t mask;
+        size_t used;
+
+        Table():
+            slots(0),
+            mask(0),
+            used(0)
+        {}
+
+        void allocate(size_t capacity) {
+            slots = static_cast<Slot*>(calloc(capacity, sizeof(Slot)));
+            assert(slots != 0);
+            mask = capacity-1;
+            used = 0;
+        }
+
+        void release() {
+            free(slots);
+            slots = 0;
+            mask = 0;
+            used = 0;
+        }
+
+        size_t capacity() const {
+            return slots == 0 ? 0 : mask+1;
+        }
+
+        Slot* find(const Key& key, size_t hash) const {
+            if(slots == 0) {
+                return 0;
+            }
+
+            size_t i = hash & mask;
+            for(uint32_t distance = 0; ; distance++, i = (i+1) & mask) {
+                Slot& s = slots[i];
+                if(ClosedSetKey<Key>::free(s.key) || s.distance < distance) {
+                    return 0;
+                }
+                if(s.key == key) {
+                    return &s;
+                }
+            }
+        }
+
+        /**
+         * @brief Key must not be there yet
+         */
+        void place(const Key& key, size_t hash, const Value& value) {
+            Slot current;
+            current.key = key;
+            current.value = value;
+            current.distance = 0;
+
+            for(size_t i = hash & mask; ; i = (i+1) & mask, current.distance++) {
+                Slot& s = slots[i];
+                if(ClosedSetKey<Key>::free(s.key)) {
+                    s = current;
+                    used++;
+                    return;
+                }
+                if(s.distance < current.distance) {
+                    std::swap(s, current);
+                }
+            }
+        }
+    };
+
+    Table active;
+    Table outgrown;
+    size_t migrated;
+    const size_t migrationStep;
+    size_t count;
+
+    void migrate(size_t slots) {
+        for(; slots > 0 && outgrown.slots != 0; slots--) {
+            const Slot& s = outgrown.slots[migrated];
+            if(!ClosedSetKey<Key>::free(s.key)) {
+                active.place(s.key, ClosedSetKey<Key>::hash(s.key), s.value);
+            }
+
+            if(++migrated == outgrown.capacity()) {
+                outgrown.release();
+            }
+        }
+    }
+
+    void grow() {
+        migrate(outgrown.capacity());
+
+        outgrown = active;
+        migrated = 0;
+        active.allocate(2*outgrown.capacity());
+    }
+
+public:
+    static const Value NotFound = Value(-1);
+
+    explicit ClosedSet(size_t capacity = 1024, size_t _migrationStep = 64):
+        active(),
+        outgrown(),
+        migrated(0),
+        migrationStep(std::max<size_t>(2, _migrationStep)),
+        count(0)
+    {
+        size_t n = 16;
+        while(n < 2*capacity) {
+            n *= 2;
+        }
+
+        active.allocate(n);
+    }
+
+    ~ClosedSet() {
+        active.release();
+        outgrown.release();
+    }
+
+    void clear() {
+        size_t capacity = active.capacity();
+
+        active.release();
+        outgrown.release();
+        active.allocate(capacity);
+        migrated = 0;
+        count = 0;
+    }
+
+    /**
+     * @brief Exchanges contents with `other`, each keeps its migration step
+     */
+    void swap(ClosedSet& other) {
+        std::swap(active, other.active);
+        std::swap(outgrown, other.outgrown);
+        std::swap(migrated, other.migrated);
+        std::swap(count, other.count);
+    }
+
+    void prefetch(size_t hash) const {
+        __builtin_prefetch(&active.slots[hash & active.mask]);
+    }
+
+    Value find(const Key& key, size_t hash) const {
+        Slot* s = active.find(key, hash);
+        if(s == 0) {
+            s = outgrown.find(key, hash);
+        }
+
+        return s == 0 ? NotFound : s->value;
+    }
+
+    Value find(const Key& key) const {
+        return find(key, ClosedSetKey<Key>::hash(key));
+    }
+
+    /**
+     * @brief Inserts the key or overwrites its value if the key is already there
+     */
+    void insert(const Key& key, size_t hash, const Value& value) {
+        assert(!ClosedSetKey<Key>::free(key));
+
+        Slot* s = active.find(key, hash);
+        if(s == 0) {
+            s = outgrown.find(key, hash);
+        }
+
+        if(s != 0) {
+            s->value = value;
+        } else {
+            if(4*(active.used+1) > 3*active.capacity()) {
+                grow();
+            }
+            active.place(key, hash, value);
+            count++;
+        }
+
+        migrate(migrationStep);
+    }
+
+    void insert(const Key& key, const Value& value) {
+        insert(key, ClosedSetKey<Key>::hash(key), value);
+    }
+
+    /**
+     * @brief Stores `value` (a cost) if the key is not there or has a greater
+     *        one, false if the key is already there at no greater cost
+     */
+    bool improve(const Key& key, size_t hash, const Value& value) {
+        Value known = find(key, hash);
+        if(known != NotFound && known <= value) {
+            return false;
+        }
+
+        insert(key, hash, value);
+        return true;
+    }
+
+    bool improve(const Key& key, const Value& value) {
+        return improve(key, ClosedSetKey<Key>::hash(key), value);
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    bool migrating() const {
+        return outgrown.slots != 0;
+    }
+
+    size_t bytes() const {
+        return (active.capacity() + outgrown.capacity())*sizeof(Slot);
+    }
+};
+
+template<typename Key, typename Value>
+const Value ClosedSet<Key, Value>::NotFound;
+
+/**
+ * @brief ClosedSet shared by several threads, split by hash into shards of
+ *        their own lock
+ */
+template<typename Key = uint64_t, typename Value = uint32_t>
+class ConcurrentClosedSet: public boost::noncopyable
+{
+    struct Shard {
+        std::mutex lock;
+        ClosedSet<Key, Value> set;
+
+        Shard(size_t capacity, size_t migrationStep):
+            lock(),
+            set(capacity, migrationStep)
+        {}
+    };
+
+    std::vector< std::unique_ptr<Shard> > shards;
+
+    Shard& shard(size_t hash) const {
+        return *shards[(hash >> 48) % shards.size()];
+    }
+
+public:
+    static const Value NotFound = ClosedSet<Key, Value>::NotFound;
+
+    explicit ConcurrentClosedSet(size_t capacity = 1 << 16, unsigned shardCount = 64, size_t migrationStep = 64):
+        shards()
+    {
+        assert(shardCount > 0);
+
+        for(unsigned i = 0; i < shardCount; i++) {
+            shards.push_back(std::unique_ptr<Shard>(new Shard(capacity/shardCount, migrationStep)));
+        }
+    }
+
+    Value find(const Key& key) const {
+        size_t hash = ClosedSetKey<Key>::hash(key);
+        Shard& s = shard(hash);
+        std::lock_guard<std::mutex> guard(s.lock);
+
+        return s.set.find(key, hash);
+    }
+
+    void insert(const Key& key, const Value& value) {
+        size_t hash = ClosedSetKey<Key>::hash(key);
+        Shard& s = shard(hash);
+        std::lock_guard<std::mutex> guard(s.lock);
+
+        s.set.insert(key, hash, value);
+    }
+
+    bool improve(const Key& key, const Value& value) {
+        size_t hash = ClosedSetKey<Key>::hash(key);
+        Shard& s = shard(hash);
+        std::lock_guard<std::mutex> guard(s.lock);
+
+        return s.set.improve(key, hash, value);
+    }
+
+    size_t size() const {
+        size_t sum = 0;
+        for(size_t i = 0; i < shards.size(); i++) {
+            std::lock_guard<std::mutex> guard(shards[i]->lock);
+            sum += shards[i]->set.size();
+        }
+
+        return sum;
+    }
+
+    size_t bytes() const {
+        size_t sum = 0;
+        for(size_t i = 0; i < shards.size(); i++) {
+            std::lock_guard<std::mutex> guard(shards[i]->lock);
+            sum += shards[i]->set.bytes();
+        }
+
+        return sum;
+    }
+};
+
+template<typename Key, typename Value>
+const Value ConcurrentClosedSet<Key, Value>::NotFound;
+
+#endif // CLOSEDSET_H
@@ -0,0 +1,187 @@
+#include "astar.h"
+#include "model.h"
+#include "actions.h"
+#include "packed.h"
+#include "manhattan.h"
+#include "closedset.h"
+#include "packedastar.h"
+#include "symmetry.h"
+#include <thread>
+#include <unordered_map>
+#include <gtest/gtest.h>
+#include <stdlib.h>
+
+uint64_t randomKey() {
+    return (uint64_t(rand()) << 33) ^ (uint64_t(rand()) << 11) ^ rand() ^ 1;
+}
+
+TEST(ClosedSet, shouldBehaveAsAMapWhileGrowing) {
+    srand(37);
+
+    ClosedSet<uint64_t, uint32_t> set(16, 2);
+    std::unordered_map<uint64_t, uint32_t> reference;
+
+    bool migrated = false;
+    for(unsigned i = 0; i < 100000; i++) {
+        uint64_t key = i % 3 == 0 && !reference.empty() ? reference.begin()->first + i % 7 : randomKey();
+        if(key == 0) {
+            continue;
+        }
+
+        set.insert(key, i);
+        reference[key] = i;
+        migrated = migrated || set.migrating();
+
+        if(i % 997 == 0) {
+            for(std::unordered_map<uint64_t, uint32_t>::const_iterator it = reference.begin(); it != reference.end(); ++it) {
+                ASSERT_EQ(set.find(it->first), it->second);
+            }
+        }
+    }
+
+    EXPECT_TRUE(migrated);
+    EXPECT_EQ(set.size(), reference.size());
+    EXPECT_EQ(set.find(0x123456789ULL << 1), ClosedSet<>::NotFound);
+    for(std::unordered_map<uint64_t, uint32_t>::const_iterator it = reference.begin(); it != reference.end(); ++it) {
+        ASSERT_EQ(set.find(it->first), it->second);
+    }
+}
+
+TEST(ClosedSet, shouldKeepBestCostOfWideKeys) {
+    ClosedSet<PackedKey128, Cost> set;
+
+    PackedKey128 a = {1, 0};
+    PackedKey128 b = {0, 1};
+
+    EXPECT_TRUE(set.improve(a, 10));
+    EXPECT_TRUE(set.improve(b, 10));
+    EXPECT_FALSE(set.improve(a, 10));
+    EXPECT_TRUE(set.improve(a, 7));
+    EXPECT_FALSE(set.improve(a, 8));
+
+    EXPECT_EQ(set.find(a), 7);
+    EXPECT_EQ(set.find(b), 10);
+    EXPECT_EQ(set.size(), 2u);
+}
+
+TEST(ClosedSet, shouldTakeAFractionOfUnorderedSetOfFields) {
+    ClosedSet<PackedField, Cost> set;
+    std::unordered_set<Field> fields;
+
+    PackedField p = packedGoal(4);
+    unsigned blank = blankAt(p, 4);
+    for(unsigned i = 0; i < 20000; i++) {
+        unsigned to = neighbour(blank, static_cast<Direction>(rand()%4), 4);
+        if(to < 16) {
+            p = slide(p, blank, to);
+            blank = to;
+        }
+
+        set.insert(p, i);
+        fields.insert(unpack(p, 4));
+    }
+
+    ASSERT_EQ(set.size(), fields.size());
+
+    // a Field is a vector of 16 places on the heap, behind a hash node
+    size_t fieldBytes = sizeof(Field) + 16*sizeof(Place) + 2*sizeof(void*);
+    EXPECT_LT(5*set.bytes(), fields.size()*fieldBytes);
+}
+
+TEST(ConcurrentClosedSet, shouldKeepBestCostFromManyThreads) {
+    ConcurrentClosedSet<uint64_t, Cost> set(1024, 8);
+
+    std::vector<std::thread> threads;
+    for(unsigned t = 0; t < 4; t++) {
+        threads.push_back(std::thread([&set, t]() {
+            for(uint64_t key = 1; key <= 20000; key++) {
+                set.improve(key, Cost(key % 100 + t));
+            }
+        }));
+    }
+    for(size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+
+    EXPECT_EQ(set.size(), 20000u);
+    for(uint64_t key = 1; key <= 20000; key++) {
+        ASSERT_EQ(set.find(key), Cost(key % 100));
+    }
+}
+
+TEST(ClosedSet, shouldServeAsClosedSetOfGraphPlan) {
+    srand(37);
+
+    std::vector<FifteenAction*> actions;
+    allPossibleActions(Field(3), actions);
+
+    ClosedSet<PackedField, Cost> closed;
+
+    for(unsigned i = 0; i < 5; i++) {
+        PackedField p = packedGoal(3);
+        unsigned blank = blankAt(p, 3);
+        for(unsigned s = 0; s < 100; s++) {
+            unsigned to = neighbour(blank, static_cast<Direction>(rand()%4), 3);
+            if(to < 9) {
+                p = slide(p, blank, to);
+                blank = to;
+            }
+        }
+
+        Field f = unpack(p, 3);
+        TracedDomain<Field, FifteenAction*> reference(f);
+        TracedDomain<Field, FifteenAction*> compact(f);
+
+        ASSERT_TRUE(graph_plan(f, Field(3), PackedManhattanHeuristic(), actions.begin(), actions.end(), reference));
+        ASSERT_TRUE(graph_plan(f, Field(3), PackedManhattanHeuristic(), actions.begin(), actions.end(), closed, compact));
+
+        EXPECT_TRUE(compact.domain() == Field(3));
+        EXPECT_EQ(compact.actions().size(), reference.actions().size());
+    }
+}
+
+TEST(ClosedSet, shouldKeepOneEntryPerSymmetryClass) {
+    srand(39);
+
+    std::vector<FifteenAction*> actions;
+    allPossibleActions(Field(3), actions);
+
+    for(unsigned i = 0; i < 5; i++) {
+        PackedField p = packedGoal(3);
+        unsigned blank = blankAt(p, 3);
+        for(unsigned s = 0; s < 100; s++) {
+            unsigned to = neighbour(blank, static_cast<Direction>(rand()%4), 3);
+            if(to < 9) {
+                p = slide(p, blank, to);
+                blank = to;
+            }
+        }
+
+        Field f = unpack(p, 3);
+        TracedDomain<Field, FifteenAction*> reference(f);
+        TracedDomain<Field, FifteenAction*> canonical(f);
+
+        ClosedSet<PackedField, Cost> closed;
+        ASSERT_TRUE(graph_plan(f, Field(3), PackedManhattanHeuristic(), actions.begin(), actions.end(), reference));
+
+        GenericAStar<
+                Field,
+                FifteenAction*,
+                CanonicalClosedVisitor<Field>,
+                std::vector<FifteenAction*>::iterator,
+                FinalStateGoal<Field>,
+                PackedManhattanHeuristic
+                >
+                planner(f, Field(3), actions.begin(), actions.end(), PackedManhattanHeuristic(),
+                        PathCost<Field, FifteenAction*>(), CanonicalClosedVisitor<Field>(&closed));
+
+        ASSERT_TRUE(planner.plan(canonical));
+        EXPECT_TRUE(canonical.domain() == Field(3));
+        EXPECT_EQ(canonical.actions().size(), reference.actions().size());
+    }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
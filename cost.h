@@ -0,0 +1,6 @@
+#ifndef COST_H
+#define COST_H
+
+typedef int Cost;
+
+#endif // COST_H
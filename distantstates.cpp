@@ -1,29 +1,16 @@
 #include "model.h"
 #include "actions.h"
+#include "symmetry.h"
 #include <unordered_set>
+#include <string>
+#include <stdlib.h>
 
-struct AllActionsAtThisPosition {
-    std::vector<FifteenAction*>* actions;
-
-    void operator()(const Place& p){
-        MoveDown* d = new MoveDown(p.position);
-        MoveUp* u = new MoveUp(p.position);
-        MoveLeft* l = new MoveLeft(p.position);
-        MoveRight* r = new MoveRight(p.position);
-
-        actions->push_back(l);
-        actions->push_back(r);
-        actions->push_back(u);
-        actions->push_back(d);
-    }
-};
-
-void allPossibleActions(const Field& f, std::vector<FifteenAction*>& actions) {
-    AllActionsAtThisPosition actionsFunctor;
-    actionsFunctor.actions = &actions;
-
-    std::for_each(f.begin(), f.end(), actionsFunctor);
-}
+/**
+ * @brief With `canonicalOnly` a layer keeps one field per symmetry class:
+ *        fields reachable from a mirror are mirrors of those reachable from
+ *        the field, so expanding representatives gives representatives
+ */
+bool canonicalOnly = false;
 
 void applyAllActions(const Field& f, const std::vector<FifteenAction*>& a, std::unordered_set<Field>& r) {
     std::for_each(
@@ -31,7 +18,7 @@ void applyAllActions(const Field& f, const std::vector<FifteenAction*>& a, std::
                 a.end(),
                 [&](FifteenAction* a) {
                     if((*a).isDefined(f)){
-                        r.insert((*a)(f));
+                        r.insert(canonicalOnly ? canonical((*a)(f)) : (*a)(f));
                     }
                 }
                 );
@@ -65,15 +52,23 @@ void allStatesReachableFromCurrentWithinNSteps(const std::unordered_set<Field>&
     }
 }
 
-int main() {
+int main(int argc, char** argv) {
     Field f(3);
 
+    unsigned N=27;
+    for(int i = 1; i < argc; i++) {
+        if(std::string(argv[i]) == "--canonical") {
+            canonicalOnly = true;
+        } else {
+            N = atoi(argv[i]);
+        }
+    }
+
     std::cout<<"Starting from: "<<std::endl<<f;
 
     std::unordered_set<Field> r;
 
 
-    unsigned N=27;
     std::unordered_set<Field> ff;
     ff.insert(f);
 
@@ -82,7 +77,7 @@ int main() {
 
     allStatesReachableFromCurrentWithinNSteps(ff, N, a, r);
 
-    std::cout<<"have "<<r.size()<<" states can go to through "<<N<<" steps"<<std::endl;
+    std::cout<<"have "<<r.size()<<(canonicalOnly ? " symmetry classes of" : "")<<" states can go to through "<<N<<" steps"<<std::endl;
 
 
     if(r.size() < 20) {
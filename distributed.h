@@ -0,0 +1,535 @@
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include "packed.h"
+#include "manhattan.h"
+#include "closedset.h"
+#include "packedastar.h"
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include <vector>
+#include <algorithm>
+#include <boost/utility.hpp>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace distributed {
+
+enum MessageType {
+    Seed,
+    Expand,
+    Outgoing,
+    Deliver,
+    Status,
+    Query,
+    Answer,
+    Quit
+};
+
+struct Header {
+    uint32_t type;
+    uint32_t count;
+    int32_t value;
+};
+
+/**
+ * @brief A field reached from `parent` by moving the vacant place to `move`
+ */
+struct Record {
+    PackedField state;
+    PackedField parent;
+    int32_t g;
+    uint32_t move;
+};
+
+struct Report {
+    int32_t minF;
+    uint32_t goal;
+    uint32_t overflow;
+    uint64_t stored;
+};
+
+/**
+ * @brief False instead of SIGPIPE when the other end is gone
+ */
+inline bool writeAll(int fd, const void* data, size_t length) {
+    const char* p = static_cast<const char*>(data);
+    while(length > 0) {
+        ssize_t n = ::send(fd, p, length, MSG_NOSIGNAL);
+        if(n < 0 && errno == EINTR) {
+            continue;
+        }
+        if(n <= 0) {
+            return false;
+        }
+        p += n;
+        length -= n;
+    }
+
+    return true;
+}
+
+inline bool readAll(int fd, void* data, size_t length) {
+    char* p = static_cast<char*>(data);
+    while(length > 0) {
+        ssize_t n = read(fd, p, length);
+        if(n < 0 && errno == EINTR) {
+            continue;
+        }
+        if(n <= 0) {
+            return false;
+        }
+        p += n;
+        length -= n;
+    }
+
+    return true;
+}
+
+template<typename T>
+bool send(int fd, MessageType type, int32_t value, const std::vector<T>& payload) {
+    Header h;
+    h.type = type;
+    h.count = payload.size();
+    h.value = value;
+
+    return writeAll(fd, &h, sizeof(h)) && (payload.empty() || writeAll(fd, &payload[0], payload.size()*sizeof(T)));
+}
+
+template<typename T>
+bool receive(int fd, Header& h, std::vector<T>& payload) {
+    if(!readAll(fd, &h, sizeof(h))) {
+        return false;
+    }
+
+    payload.resize(h.count);
+    return payload.empty() || readAll(fd, &payload[0], payload.size()*sizeof(T));
+}
+
+inline unsigned owner(PackedField p, unsigned workers) {
+    return (hashPacked(p) >> 32) % workers;
+}
+
+/**
+ * @brief One process of DistributedAStar: owns the fields of its partition
+ *        with their best g and parent, at most `budget` of them
+ */
+class Worker: public boost::noncopyable
+{
+    struct Node {
+        PackedField state;
+        PackedField parent;
+        Cost g;
+        Cost h;
+        uint8_t move;
+    };
+
+    const unsigned size;
+    const size_t budget;
+    const PackedField goal;
+
+    std::vector<Node> nodes;
+    ClosedSet<PackedField, uint32_t> table;
+    std::vector< std::vector<uint32_t> > open;
+    bool overflow;
+    bool goalReached;
+
+    void insert(const Record& r) {
+        uint32_t id = table.find(r.state);
+        if(id != ClosedSet<PackedField, uint32_t>::NotFound && nodes[id].g <= r.g) {
+            return;
+        }
+
+        if(id == ClosedSet<PackedField, uint32_t>::NotFound) {
+            if(nodes.size() >= budget) {
+                overflow = true;
+                return;
+            }
+
+            Node n;
+            n.state = r.state;
+            n.h = manhattan(r.state, size);
+            id = nodes.size();
+            nodes.push_back(n);
+            table.insert(r.state, id);
+        }
+
+        Node& n = nodes[id];
+        n.parent = r.parent;
+        n.g = r.g;
+        n.move = r.move;
+
+        size_t f = n.g + n.h;
+        if(open.size() <= f) {
+            open.resize(f+1);
+        }
+        open[f].push_back(id);
+    }
+
+    void expand(size_t f, std::vector<Record>& children) {
+        children.clear();
+        if(f >= open.size()) {
+            return;
+        }
+
+        std::vector<uint32_t> bucket;
+        bucket.swap(open[f]);
+
+        for(size_t i = 0; i < bucket.size(); i++) {
+            const Node& n = nodes[bucket[i]];
+            if(size_t(n.g + n.h) != f) {
+                continue;
+            }
+            if(n.state == goal) {
+                goalReached = true;
+                continue;
+            }
+
+            unsigned blank = blankAt(n.state, size);
+            for(unsigned d = Up; d <= Right; d++) {
+                if(n.g > 0 && d == inverse(static_cast<Direction>(n.move))) {
+                    continue;
+                }
+
+                unsigned to = neighbour(blank, static_cast<Direction>(d), size);
+                if(to >= size*size) {
+                    continue;
+                }
+
+                Record r;
+                r.state = slide(n.state, blank, to);
+                r.parent = n.state;
+                r.g = n.g+1;
+                r.move = d;
+                children.push_back(r);
+            }
+        }
+    }
+
+    Report report() const {
+        Report r;
+        r.minF = INT_MAX;
+        for(size_t f = 0; f < open.size(); f++) {
+            if(!open[f].empty()) {
+                r.minF = f;
+                break;
+            }
+        }
+        r.goal = goalReached;
+        r.overflow = overflow;
+        r.stored = nodes.size();
+
+        return r;
+    }
+
+public:
+
+    Worker(unsigned _size, size_t _budget):
+        size(_size),
+        budget(_budget),
+        goal(packedGoal(_size)),
+        nodes(),
+        table(),
+        open(),
+        overflow(false),
+        goalReached(false)
+    {}
+
+    /**
+     * @brief Answers the coordinator on `fd` until told to quit
+     */
+    void serve(int fd) {
+        Header h;
+        std::vector<Record> records;
+        std::vector<Record> children;
+
+        while(receive(fd, h, records)) {
+            switch(h.type) {
+            case Seed:
+            case Deliver:
+                for(size_t i = 0; i < records.size(); i++) {
+                    insert(records[i]);
+                }
+                if(h.type == Deliver) {
+                    send(fd, Status, 0, std::vector<Report>(1, report()));
+                }
+                break;
+            case Expand:
+                expand(h.value, children);
+                send(fd, Outgoing, 0, children);
+                break;
+            case Query: {
+                std::vector<Record> answer;
+                uint32_t id = records.empty() ? ClosedSet<PackedField, uint32_t>::NotFound : table.find(records[0].state);
+                if(id != ClosedSet<PackedField, uint32_t>::NotFound) {
+                    Record r;
+                    r.state = nodes[id].state;
+                    r.parent = nodes[id].parent;
+                    r.g = nodes[id].g;
+                    r.move = nodes[id].move;
+                    answer.push_back(r);
+                }
+                send(fd, Answer, 0, answer);
+                break;
+            }
+            default:
+                return;
+            }
+        }
+    }
+};
+
+}
+
+/**
+ * @brief Hash-distributed A* over packed fields run by `workers` forked
+ *        processes, each owning the fields hashing to it.
+ *
+ * The coordinator (the calling process) talks to every worker over a Unix
+ * domain socket pair and runs the search in synchronous rounds: all workers
+ * expand their open fields of the global least f, send the children back in
+ * one batch, the coordinator routes them to their owners in one batch each
+ * and collects every worker's least f. The search ends when some worker pops
+ * the goal at the global least f, which makes the solution optimal, and the
+ * plan is collected by asking owners for parents. A worker that would store
+ * more than `budget` fields makes the search fail.
+ */
+class DistributedAStar: public boost::noncopyable
+{
+    const unsigned size;
+    const unsigned workers;
+    const size_t budget;
+
+    std::vector<int> sockets;
+    std::vector<pid_t> processes;
+
+    size_t storedCount;
+    size_t peakStoredCount;
+    unsigned roundCount;
+    bool overflowed;
+
+    bool start() {
+        for(unsigned w = 0; w < workers; w++) {
+            int fds[2];
+            if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+                return false;
+            }
+
+            pid_t pid = fork();
+            if(pid < 0) {
+                close(fds[0]);
+                close(fds[1]);
+                return false;
+            }
+
+            if(pid == 0) {
+                close(fds[0]);
+                for(size_t i = 0; i < sockets.size(); i++) {
+                    close(sockets[i]);
+                }
+
+                {
+                    distributed::Worker worker(size, budget);
+                    worker.serve(fds[1]);
+                }
+                _exit(0);
+            }
+
+            close(fds[1]);
+            sockets.push_back(fds[0]);
+            processes.push_back(pid);
+        }
+
+        return true;
+    }
+
+    void stop() {
+        for(size_t w = 0; w < sockets.size(); w++) {
+            distributed::send(sockets[w], distributed::Quit, 0, std::vector<distributed::Record>());
+            close(sockets[w]);
+        }
+        for(size_t w = 0; w < processes.size(); w++) {
+            waitpid(processes[w], 0, 0);
+        }
+
+        sockets.clear();
+        processes.clear();
+    }
+
+    /**
+     * @brief One round at `f`, false on a broken connection; `reports` get
+     *        the state of every worker after it
+     */
+    bool round(int32_t f, std::vector<distributed::Report>& reports) {
+        using namespace distributed;
+
+        for(unsigned w = 0; w < workers; w++) {
+            if(!send(sockets[w], Expand, f, std::vector<Record>())) {
+                return false;
+            }
+        }
+
+        std::vector< std::vector<Record> > routed(workers);
+        Header h;
+        std::vector<Record> children;
+        for(unsigned w = 0; w < workers; w++) {
+            if(!receive(sockets[w], h, children) || h.type != Outgoing) {
+                return false;
+            }
+            for(size_t i = 0; i < children.size(); i++) {
+                routed[owner(children[i].state, workers)].push_back(children[i]);
+            }
+        }
+
+        for(unsigned w = 0; w < workers; w++) {
+            if(!send(sockets[w], Deliver, 0, routed[w])) {
+                return false;
+            }
+        }
+
+        reports.clear();
+        std::vector<Report> report;
+        for(unsigned w = 0; w < workers; w++) {
+            if(!receive(sockets[w], h, report) || h.type != Status || report.size() != 1) {
+                return false;
+            }
+            reports.push_back(report[0]);
+        }
+
+        roundCount++;
+        return true;
+    }
+
+    bool collect(std::vector<Direction>& moves) {
+        using namespace distributed;
+
+        moves.clear();
+
+        Record r;
+        r.state = packedGoal(size);
+        for(;;) {
+            unsigned w = owner(r.state, workers);
+
+            Header h;
+            std::vector<Record> answer;
+            if(!send(sockets[w], Query, 0, std::vector<Record>(1, r)) ||
+               !receive(sockets[w], h, answer) || answer.size() != 1) {
+                return false;
+            }
+
+            r = answer[0];
+            if(r.g == 0) {
+                break;
+            }
+            moves.push_back(static_cast<Direction>(r.move));
+            r.state = r.parent;
+        }
+
+        std::reverse(moves.begin(), moves.end());
+        return true;
+    }
+
+public:
+
+    DistributedAStar(unsigned _size, unsigned _workers, size_t _budget = 1 << 20):
+        size(_size),
+        workers(std::max(1u, _workers)),
+        budget(_budget),
+        sockets(),
+        processes(),
+        storedCount(0),
+        peakStoredCount(0),
+        roundCount(0),
+        overflowed(false)
+    {
+        assert(size <= MaxPackedSize);
+    }
+
+    ~DistributedAStar() {
+        stop();
+    }
+
+    bool plan(PackedField initial, std::vector<Direction>& moves) {
+        using namespace distributed;
+
+        storedCount = 0;
+        peakStoredCount = 0;
+        roundCount = 0;
+        overflowed = false;
+
+        if(!start()) {
+            stop();
+            return false;
+        }
+
+        Record seed;
+        seed.state = initial;
+        seed.parent = initial;
+        seed.g = 0;
+        seed.move = 0;
+        if(!send(sockets[owner(initial, workers)], Seed, 0, std::vector<Record>(1, seed))) {
+            stop();
+            return false;
+        }
+
+        int32_t f = manhattan(initial, size);
+        bool solved = false;
+
+        std::vector<Report> reports;
+        while(round(f, reports)) {
+            bool goal = false;
+            int32_t next = INT_MAX;
+
+            storedCount = 0;
+            for(size_t w = 0; w < reports.size(); w++) {
+                goal = goal || reports[w].goal;
+                overflowed = overflowed || reports[w].overflow;
+                next = std::min(next, reports[w].minF);
+                storedCount += reports[w].stored;
+                peakStoredCount = std::max<size_t>(peakStoredCount, reports[w].stored);
+            }
+
+            if(goal) {
+                solved = collect(moves);
+                break;
+            }
+            if(overflowed || next == INT_MAX) {
+                break;
+            }
+            f = next;
+        }
+
+        stop();
+        return solved;
+    }
+
+    /**
+     * @brief Fields stored by all workers together at the end of the last plan
+     */
+    size_t stored() const {
+        return storedCount;
+    }
+
+    /**
+     * @brief Most fields stored by one worker
+     */
+    size_t peakStored() const {
+        return peakStoredCount;
+    }
+
+    unsigned rounds() const {
+        return roundCount;
+    }
+
+    /**
+     * @brief Whether the last plan failed because a worker ran out of budget
+     */
+    bool outOfBudget() const {
+        return overflowed;
+    }
+};
+
+#endif // DISTRIBUTED_H
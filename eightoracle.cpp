@@ -0,0 +1,20 @@
+#include "eightoracle.h"
+#include <iostream>
+
+int main(int argc, char** argv) {
+    if(argc != 2) {
+        std::cerr<<"usage: "<<argv[0]<<" <distances file>"<<std::endl;
+        return 1;
+    }
+
+    EightPuzzleOracle oracle;
+    oracle.generate();
+
+    if(!oracle.save(argv[1])) {
+        std::cerr<<"could not write "<<argv[1]<<std::endl;
+        return 1;
+    }
+
+    std::cout<<oracle.reachable()<<" fields reachable, at most "<<oracle.diameter()<<" moves away, written to "<<argv[1]<<std::endl;
+    return 0;
+}
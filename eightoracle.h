@@ -0,0 +1,215 @@
+#ifndef EIGHTORACLE_H
+#define EIGHTORACLE_H
+
+#include "astar.h"
+#include "packed.h"
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <functional>
+
+/**
+ * @brief Position of a 3x3 field among all 9! permutations of its places
+ *        (Lehmer code), the vacant place counting as tile 0
+ */
+inline uint32_t rankEight(PackedField p) {
+    uint32_t rank = 0;
+    unsigned seen = 0;
+
+    for(unsigned cell = 0; cell < 9; cell++) {
+        unsigned tile = tileAt(p, cell);
+        unsigned smaller = __builtin_popcount(seen & ((1u << tile) - 1));
+
+        rank = rank*(9-cell) + (tile - smaller);
+        seen |= 1u << tile;
+    }
+
+    return rank;
+}
+
+/**
+ * @brief Exact distance to Field(3) of every 8-puzzle, one byte per ranked
+ *        field, computed once by a retrograde BFS from the goal
+ */
+class EightPuzzleOracle {
+public:
+    enum {
+        Fields = 362880,
+        Diameter = 31,
+        Unreachable = 0xFF
+    };
+
+private:
+    static const char* magic() {
+        return "EIGHTORC";
+    }
+
+    std::vector<uint8_t> distances;
+
+public:
+
+    EightPuzzleOracle():
+        distances()
+    {}
+
+    bool ready() const {
+        return distances.size() == Fields;
+    }
+
+    void generate() {
+        distances.assign(Fields, Unreachable);
+
+        std::vector<PackedField> frontier;
+        std::vector<PackedField> next;
+
+        const PackedField goal = packedGoal(3);
+        distances[rankEight(goal)] = 0;
+        frontier.push_back(goal);
+
+        for(uint8_t depth = 1; !frontier.empty(); depth++) {
+            next.clear();
+
+            for(size_t i = 0; i < frontier.size(); i++) {
+                unsigned blank = blankAt(frontier[i], 3);
+
+                for(unsigned d = Up; d <= Right; d++) {
+                    unsigned to = neighbour(blank, static_cast<Direction>(d), 3);
+                    if(to >= 9) {
+                        continue;
+                    }
+
+                    PackedField n = slide(frontier[i], blank, to);
+                    uint8_t& known = distances[rankEight(n)];
+                    if(known == Unreachable) {
+                        known = depth;
+                        next.push_back(n);
+                    }
+                }
+            }
+
+            frontier.swap(next);
+        }
+    }
+
+    size_t reachable() const {
+        return Fields - std::count(distances.begin(), distances.end(), uint8_t(Unreachable));
+    }
+
+    unsigned diameter() const {
+        unsigned deepest = 0;
+        for(size_t i = 0; i < distances.size(); i++) {
+            if(distances[i] != Unreachable) {
+                deepest = std::max<unsigned>(deepest, distances[i]);
+            }
+        }
+
+        return deepest;
+    }
+
+    bool save(const char* path) const {
+        assert(ready());
+
+        std::ofstream out(path, std::ios::binary);
+        out.write(magic(), 8);
+        out.write(reinterpret_cast<const char*>(&distances[0]), distances.size());
+
+        return out.good();
+    }
+
+    /**
+     * @brief False if the file is not a complete table of valid distances,
+     *        the table is then left as it was
+     */
+    bool load(const char* path) {
+        std::ifstream in(path, std::ios::binary);
+
+        char header[8];
+        in.read(header, 8);
+        if(!in || memcmp(header, magic(), 8) != 0) {
+            return false;
+        }
+
+        std::vector<uint8_t> loaded(Fields + 1);
+        in.read(reinterpret_cast<char*>(&loaded[0]), loaded.size());
+        if(in.gcount() != Fields) {
+            return false;
+        }
+        loaded.pop_back();
+
+        for(size_t i = 0; i < loaded.size(); i++) {
+            if(loaded[i] > Diameter && loaded[i] != Unreachable) {
+                return false;
+            }
+        }
+        if(loaded[rankEight(packedGoal(3))] != 0) {
+            return false;
+        }
+
+        distances.swap(loaded);
+        return true;
+    }
+
+    /**
+     * @brief Number of moves to Field(3), Unreachable for the other parity
+     */
+    unsigned distance(PackedField p) const {
+        assert(ready());
+        return distances[rankEight(p)];
+    }
+
+    /**
+     * @brief Walks to the goal always moving to a neighbour one step closer,
+     *        false if there is none (a corrupt table)
+     */
+    bool solve(PackedField p, std::vector<Direction>& moves) const {
+        moves.clear();
+
+        unsigned left = distance(p);
+        if(left == Unreachable) {
+            return false;
+        }
+
+        while(left > 0) {
+            unsigned blank = blankAt(p, 3);
+
+            unsigned d = Up;
+            for(; d <= Right; d++) {
+                unsigned to = neighbour(blank, static_cast<Direction>(d), 3);
+                if(to < 9 && distance(slide(p, blank, to)) == left-1) {
+                    p = slide(p, blank, to);
+                    moves.push_back(static_cast<Direction>(d));
+                    break;
+                }
+            }
+
+            if(d > Right) {
+                moves.clear();
+                return false;
+            }
+            left--;
+        }
+
+        return true;
+    }
+};
+
+/**
+ * @brief Exact heuristic for 3x3 fields, the reference other heuristics and
+ *        planners can be validated against
+ */
+struct EightPuzzleOracleHeuristic: std::unary_function<const Field&, Cost> {
+    const EightPuzzleOracle* oracle;
+
+    EightPuzzleOracleHeuristic(const EightPuzzleOracle* _oracle):
+        oracle(_oracle)
+    {}
+
+    Cost operator ()(const Field& f) const {
+        assert(f.size == 3);
+        return oracle->distance(pack(f));
+    }
+};
+
+#endif // EIGHTORACLE_H
@@ -0,0 +1,229 @@
+#ifndef FRINGE_H
+#define FRINGE_H
+
+#include "astar.h"
+#include <list>
+#include <limits.h>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <boost/utility.hpp>
+
+/**
+ * @brief Fringe search: IDA*-like iterations on an f threshold that resume
+ *        from the frontier left by the previous one instead of the root.
+ *
+ * The frontier is a doubly linked list visited from its head: a node above
+ * the threshold is kept for the next iteration ("later"), a node within it is
+ * replaced in place by its children, which are visited in this iteration
+ * ("now"). A cache keeps the best g, h and parent of every domain reached, so
+ * a domain is only put back when reached cheaper. Actions price themselves
+ * as with PathCost; with a consistent heuristic the first goal visited is
+ * an optimal one.
+ */
+template<
+        typename Domain,
+        typename ActionPtr,
+        typename ActionIterator,
+        typename GoalTest,
+        typename CostFunction
+        >
+class FringeSearch: public boost::noncopyable
+{
+    typedef std::list<const Domain*> Fringe;
+
+    struct Entry {
+        Cost g;
+        Cost h;
+        const Domain* parent;
+        ActionPtr action;
+        bool listed;
+        typename Fringe::iterator position;
+    };
+
+    typedef std::unordered_map<Domain, Entry> Cache;
+
+    const Domain initial;
+    const std::vector<ActionPtr> universe;
+    GoalTest goal;
+    CostFunction heuristic;
+
+    Cache cache;
+    Fringe fringe;
+    size_t expandedCount;
+    unsigned iterationCount;
+
+    void path(const Domain* d, TracedDomain<Domain, ActionPtr>& solution) const {
+        std::vector<ActionPtr> actions;
+        for(const Entry* e = &cache.find(*d)->second; e->parent != 0; e = &cache.find(*e->parent)->second) {
+            actions.push_back(e->action);
+        }
+
+        solution = TracedDomain<Domain, ActionPtr>(initial);
+        for(size_t a = actions.size(); a > 0; a--) {
+            solution.accept(actions[a-1]);
+        }
+    }
+
+    /**
+     * @brief Replaces `*it` by its children, returns the first of them (or
+     *        the node that followed it)
+     */
+    typename Fringe::iterator expand(typename Fringe::iterator it) {
+        const Domain& d = **it;
+        Entry& from = cache.find(d)->second;
+        const Cost g = from.g;
+
+        typename Fringe::iterator next = it;
+        ++next;
+        typename Fringe::iterator first = fringe.end();
+
+        for(size_t a = 0; a < universe.size(); a++) {
+            const ActionPtr action = universe[a];
+            if(!(*action).isDefined(d)) {
+                continue;
+            }
+
+            Domain child = (*action)(d);
+            Cost childG = g + (*action).cost(d);
+
+            typename Cache::iterator known = cache.find(child);
+            if(known != cache.end()) {
+                if(known->second.g <= childG) {
+                    continue;
+                }
+                if(known->second.listed) {
+                    if(known->second.position == next) {
+                        ++next;
+                    }
+                    fringe.erase(known->second.position);
+                }
+            } else {
+                Entry e;
+                e.h = heuristic(child);
+                known = cache.insert(std::make_pair(child, e)).first;
+            }
+
+            Entry& e = known->second;
+            e.g = childG;
+            e.parent = &d;
+            e.action = action;
+            e.listed = true;
+            e.position = fringe.insert(next, &known->first);
+            if(first == fringe.end()) {
+                first = e.position;
+            }
+        }
+
+        expandedCount++;
+        from.listed = false;
+        fringe.erase(it);
+
+        return first != fringe.end() ? first : next;
+    }
+
+public:
+
+    FringeSearch(
+            const Domain& _initial,
+            const ActionIterator& actions_begin,
+            const ActionIterator& actions_end,
+            const GoalTest& _goal,
+            const CostFunction& _heuristic
+            ):
+        initial(_initial),
+        universe(actions_begin, actions_end),
+        goal(_goal),
+        heuristic(_heuristic),
+        cache(),
+        fringe(),
+        expandedCount(0),
+        iterationCount(0)
+    {}
+
+    bool plan(TracedDomain<Domain, ActionPtr>& solution) {
+        cache.clear();
+        fringe.clear();
+        expandedCount = 0;
+        iterationCount = 0;
+
+        Entry root;
+        root.g = 0;
+        root.h = heuristic(initial);
+        root.parent = 0;
+        root.listed = true;
+
+        typename Cache::iterator start = cache.insert(std::make_pair(initial, root)).first;
+        start->second.position = fringe.insert(fringe.end(), &start->first);
+
+        Cost threshold = root.h;
+        while(!fringe.empty()) {
+            Cost next = INT_MAX;
+            iterationCount++;
+
+            for(typename Fringe::iterator it = fringe.begin(); it != fringe.end(); ) {
+                const Entry& e = cache.find(**it)->second;
+                const Cost f = e.g + e.h;
+
+                if(f > threshold) {
+                    next = std::min(next, f);
+                    ++it;
+                    continue;
+                }
+
+                if(goal(**it)) {
+                    path(*it, solution);
+                    return true;
+                }
+
+                it = expand(it);
+            }
+
+            threshold = next;
+        }
+
+        return false;
+    }
+
+    size_t expanded() const {
+        return expandedCount;
+    }
+
+    /**
+     * @brief Thresholds tried by the last plan
+     */
+    unsigned iterations() const {
+        return iterationCount;
+    }
+
+    /**
+     * @brief Domains in the cache after the last plan
+     */
+    size_t cached() const {
+        return cache.size();
+    }
+};
+
+template <typename Domain, typename ActionPtr, typename ActionsIterator, typename CostFunction>
+bool fringe_plan(
+        const Domain& initial,
+        const Domain& final,
+        const CostFunction heuristic,
+        const ActionsIterator actionsBegin,
+        const ActionsIterator actionsEnd,
+        TracedDomain<Domain, ActionPtr>& history
+        ) {
+
+    FringeSearch<
+            Domain,
+            ActionPtr,
+            ActionsIterator,
+            FinalStateGoal<Domain>,
+            CostFunction
+            >
+            planner(initial, actionsBegin, actionsEnd, FinalStateGoal<Domain>(final), heuristic);
+
+    return planner.plan(history);
+}
+
+#endif // FRINGE_H
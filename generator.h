@@ -0,0 +1,221 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include "model.h"
+#include "packed.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+
+/**
+ * Instances of any size are tiles in place order, 0 for the vacant place,
+ * as binary::tiles gives them.
+ */
+namespace generator {
+
+/**
+ * @brief xorshift64*, the same sequence for the same seed everywhere
+ */
+class Random {
+    uint64_t state;
+
+public:
+    explicit Random(uint64_t seed):
+        state(seed*0x9e3779b97f4a7c15ULL + 1)
+    {}
+
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+
+        return state*0x2545f4914f6cdd1dULL;
+    }
+
+    /**
+     * @brief Uniform in [0, n)
+     */
+    unsigned below(unsigned n) {
+        return (uint64_t(uint32_t(next() >> 32))*n) >> 32;
+    }
+};
+
+/**
+ * @brief Whether Field(size) can be reached: the permutation of places (the
+ *        vacant one as tile size*size) must have the parity of the distance
+ *        of the vacant place from its own
+ */
+inline bool solvable(const std::vector<unsigned>& tiles, unsigned size) {
+    const unsigned n = size*size;
+
+    std::vector<bool> seen(n, false);
+    unsigned transpositions = 0;
+    unsigned blank = 0;
+
+    for(unsigned cell = 0; cell < n; cell++) {
+        if(tiles[cell] == 0) {
+            blank = cell;
+        }
+        if(seen[cell]) {
+            continue;
+        }
+
+        unsigned length = 0;
+        for(unsigned c = cell; !seen[c]; length++) {
+            seen[c] = true;
+            c = tiles[c] == 0 ? n-1 : tiles[c]-1;
+        }
+        transpositions += length-1;
+    }
+
+    unsigned distance = (size-1 - blank/size) + (size-1 - blank%size);
+    return transpositions%2 == distance%2;
+}
+
+inline unsigned manhattan(const std::vector<unsigned>& tiles, unsigned size) {
+    unsigned sum = 0;
+    for(unsigned cell = 0; cell < size*size; cell++) {
+        if(tiles[cell] != 0) {
+            unsigned goal = tiles[cell]-1;
+            sum += abs(int(cell/size) - int(goal/size)) + abs(int(cell%size) - int(goal%size));
+        }
+    }
+
+    return sum;
+}
+
+inline Field field(const std::vector<unsigned>& tiles, unsigned size) {
+    std::vector<Place> places;
+    for(unsigned cell = 0; cell < size*size; cell++) {
+        Position pos(cell/size, cell%size);
+        if(tiles[cell] == 0) {
+            places.push_back(Place(pos));
+        } else {
+            places.push_back(Place(pos, Tile(tiles[cell])));
+        }
+    }
+
+    return Field(places);
+}
+
+inline PackedField pack(const std::vector<unsigned>& tiles) {
+    PackedField p = 0;
+    for(unsigned cell = 0; cell < tiles.size(); cell++) {
+        p = withTile(p, cell, tiles[cell]);
+    }
+
+    return p;
+}
+
+}
+
+/**
+ * @brief Solvable instances of one size, reproducible from the seed
+ */
+class InstanceGenerator {
+    /**
+     * @brief Moves of the vacant place from a cell after a move, except the
+     *        one undoing it
+     */
+    struct Options {
+        unsigned count;
+        uint8_t direction[4];
+        unsigned to[4];
+    };
+
+    const unsigned size;
+    generator::Random random;
+    std::vector<Options> options;
+
+public:
+
+    InstanceGenerator(unsigned _size, uint64_t seed):
+        size(_size),
+        random(seed),
+        options(_size*_size*5)
+    {
+        const unsigned n = size*size;
+
+        for(unsigned cell = 0; cell < n; cell++) {
+            for(unsigned last = 0; last <= 4; last++) {
+                Options& o = options[cell*5 + last];
+                o.count = 0;
+
+                for(unsigned d = Up; d <= Right; d++) {
+                    if(last != 4 && d == inverse(static_cast<Direction>(last))) {
+                        continue;
+                    }
+                    if((d == Up && cell < size) || (d == Down && cell >= n-size) ||
+                       (d == Left && cell%size == 0) || (d == Right && cell%size == size-1)) {
+                        continue;
+                    }
+
+                    o.direction[o.count] = d;
+                    o.to[o.count] = d == Up ? cell-size : d == Down ? cell+size : d == Left ? cell-1 : cell+1;
+                    o.count++;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Uniformly random among all solvable instances: a random
+     *        permutation, with two tiles swapped if of the wrong parity
+     */
+    void uniform(std::vector<unsigned>& tiles) {
+        const unsigned n = size*size;
+
+        tiles.resize(n);
+        for(unsigned cell = 0; cell < n; cell++) {
+            tiles[cell] = cell;
+        }
+        for(unsigned cell = n-1; cell > 0; cell--) {
+            std::swap(tiles[cell], tiles[random.below(cell+1)]);
+        }
+
+        if(!generator::solvable(tiles, size)) {
+            unsigned first = tiles[0] == 0 ? 1 : 0;
+            unsigned second = tiles[first+1] == 0 ? first+2 : first+1;
+            std::swap(tiles[first], tiles[second]);
+        }
+    }
+
+    /**
+     * @brief `length` random moves of the vacant place from Field(size),
+     *        never undoing the previous one
+     */
+    void walk(unsigned length, std::vector<unsigned>& tiles) {
+        const unsigned n = size*size;
+
+        tiles.resize(n);
+        for(unsigned cell = 0; cell+1 < n; cell++) {
+            tiles[cell] = cell+1;
+        }
+        tiles[n-1] = 0;
+
+        unsigned blank = n-1;
+        unsigned last = 4;
+        for(unsigned i = 0; i < length; i++) {
+            const Options& o = options[blank*5 + last];
+            unsigned k = random.below(o.count);
+
+            tiles[blank] = tiles[o.to[k]];
+            blank = o.to[k];
+            last = o.direction[k];
+        }
+        tiles[blank] = 0;
+    }
+
+    /**
+     * @brief Field(size) shuffled by a walk of `length` moves
+     */
+    Field shuffled(unsigned length) {
+        std::vector<unsigned> tiles;
+        walk(length, tiles);
+
+        return generator::field(tiles, size);
+    }
+};
+
+#endif // GENERATOR_H
@@ -0,0 +1,82 @@
+#include "packed.h"
+#include "generator.h"
+#include "eightoracle.h"
+#include <gtest/gtest.h>
+#include <set>
+
+TEST(InstanceGenerator, solvabilityShouldMatchReachability) {
+    EightPuzzleOracle oracle;
+    oracle.generate();
+
+    InstanceGenerator generator(3, 43);
+    generator::Random random(43);
+
+    std::vector<unsigned> tiles;
+    for(unsigned i = 0; i < 2000; i++) {
+        generator.uniform(tiles);
+        EXPECT_NE(oracle.distance(generator::pack(tiles)), unsigned(EightPuzzleOracle::Unreachable));
+
+        std::swap(tiles[random.below(9)], tiles[random.below(9)]);
+        EXPECT_EQ(generator::solvable(tiles, 3), oracle.distance(generator::pack(tiles)) != EightPuzzleOracle::Unreachable);
+    }
+}
+
+TEST(InstanceGenerator, walksShouldStayWithinTheirLength) {
+    EightPuzzleOracle oracle;
+    oracle.generate();
+
+    InstanceGenerator generator(3, 44);
+
+    std::vector<unsigned> tiles;
+    for(unsigned length = 0; length < 40; length++) {
+        generator.walk(length, tiles);
+
+        EXPECT_TRUE(generator::solvable(tiles, 3));
+        EXPECT_LE(oracle.distance(generator::pack(tiles)), length);
+        EXPECT_EQ(oracle.distance(generator::pack(tiles)) % 2, length % 2);
+        EXPECT_LE(generator::manhattan(tiles, 3), length);
+    }
+
+    InstanceGenerator large(10, 45);
+    for(unsigned i = 0; i < 100; i++) {
+        large.walk(1000, tiles);
+        EXPECT_TRUE(generator::solvable(tiles, 10));
+        large.uniform(tiles);
+        EXPECT_TRUE(generator::solvable(tiles, 10));
+    }
+}
+
+TEST(InstanceGenerator, shouldBeReproducibleFromTheSeed) {
+    InstanceGenerator first(4, 7);
+    InstanceGenerator second(4, 7);
+    InstanceGenerator other(4, 8);
+
+    std::set<PackedField> distinct;
+    std::vector<unsigned> a;
+    std::vector<unsigned> b;
+    std::vector<unsigned> c;
+    unsigned differing = 0;
+
+    for(unsigned i = 0; i < 1000; i++) {
+        first.uniform(a);
+        second.uniform(b);
+        other.uniform(c);
+
+        EXPECT_TRUE(a == b);
+        differing += a != c;
+        distinct.insert(generator::pack(a));
+
+        first.walk(50, a);
+        second.walk(50, b);
+        other.walk(50, c);
+        EXPECT_TRUE(a == b);
+    }
+
+    EXPECT_GT(differing, 990u);
+    EXPECT_EQ(distinct.size(), 1000u);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,154 @@
+#ifndef HEURISTICCACHE_H
+#define HEURISTICCACHE_H
+
+#include "model.h"
+#include "astar.h"
+#include "closedset.h"
+#include <stdint.h>
+#include <vector>
+#include <assert.h>
+#include <functional>
+#include <boost/optional.hpp>
+#include <boost/utility.hpp>
+
+/**
+ * @brief Fixed capacity cache of heuristic values by domain fingerprint.
+ *
+ * Buckets of `Ways` entries (1 is direct mapped), a fingerprint lives in the
+ * bucket its low bits point to and a full bucket replaces its entries in
+ * turn. Entries keep the domain itself, so a fingerprint collision is a miss
+ * and never a wrong value.
+ */
+template<typename _Domain, unsigned Ways = 2>
+class HeuristicCache: public boost::noncopyable
+{
+public:
+    typedef _Domain Domain;
+
+private:
+    struct Entry {
+        uint64_t fingerprint;
+        boost::optional<Domain> domain;
+        Cost cost;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<uint8_t> victims;
+    uint64_t mask;
+    size_t hitCount;
+    size_t missCount;
+
+public:
+
+    /**
+     * @brief Holds at most `capacity` domains, rounded down to a power of two
+     *        number of buckets; `capacity` has to fit one bucket
+     */
+    explicit HeuristicCache(size_t capacity = 1 << 16):
+        entries(),
+        victims(),
+        mask(0),
+        hitCount(0),
+        missCount(0)
+    {
+        assert(capacity >= Ways);
+
+        size_t buckets = 1;
+        while(2*buckets*Ways <= capacity) {
+            buckets *= 2;
+        }
+
+        entries.resize(buckets*Ways);
+        victims.assign(buckets, 0);
+        mask = buckets-1;
+    }
+
+    static uint64_t fingerprint(const Domain& d) {
+        return ClosedSetKey<uint64_t>::hash(std::hash<Domain>()(d));
+    }
+
+    bool lookup(const Domain& d, uint64_t fingerprint, Cost& cost) {
+        const Entry* b = &entries[(fingerprint & mask)*Ways];
+
+        for(unsigned i = 0; i < Ways; i++) {
+            if(b[i].domain && b[i].fingerprint == fingerprint && *b[i].domain == d) {
+                cost = b[i].cost;
+                hitCount++;
+                return true;
+            }
+        }
+
+        missCount++;
+        return false;
+    }
+
+    void store(const Domain& d, uint64_t fingerprint, Cost cost) {
+        const size_t bucket = fingerprint & mask;
+        Entry* b = &entries[bucket*Ways];
+
+        unsigned way = victims[bucket];
+        for(unsigned i = 0; i < Ways; i++) {
+            if(!b[i].domain) {
+                way = i;
+                break;
+            }
+        }
+        if(way == victims[bucket]) {
+            victims[bucket] = (way+1) % Ways;
+        }
+
+        b[way].fingerprint = fingerprint;
+        b[way].domain = d;
+        b[way].cost = cost;
+    }
+
+    void clear() {
+        for(size_t i = 0; i < entries.size(); i++) {
+            entries[i].domain = boost::none;
+        }
+        victims.assign(victims.size(), 0);
+        hitCount = 0;
+        missCount = 0;
+    }
+
+    size_t capacity() const {
+        return entries.size();
+    }
+
+    size_t hits() const {
+        return hitCount;
+    }
+
+    size_t misses() const {
+        return missCount;
+    }
+};
+
+/**
+ * @brief Heuristic consulting `cache` before evaluating `heuristic`, a drop-in
+ *        CostFunction of GenericAStar; copies share the cache
+ */
+template<typename Heuristic, typename Cache = HeuristicCache<Field> >
+struct CachedHeuristic: std::unary_function<const typename Cache::Domain&, Cost> {
+    Heuristic heuristic;
+    Cache* cache;
+
+    CachedHeuristic(Cache* _cache, const Heuristic& _heuristic = Heuristic()):
+        heuristic(_heuristic),
+        cache(_cache)
+    {}
+
+    Cost operator()(const typename Cache::Domain& d) const {
+        uint64_t fingerprint = Cache::fingerprint(d);
+
+        Cost cost;
+        if(!cache->lookup(d, fingerprint, cost)) {
+            cost = heuristic(d);
+            cache->store(d, fingerprint, cost);
+        }
+
+        return cost;
+    }
+};
+
+#endif // HEURISTICCACHE_H
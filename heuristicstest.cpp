@@ -0,0 +1,289 @@
+#include "packed.h"
+#include "manhattan.h"
+#include "heuristictables.h"
+#include "eightoracle.h"
+#include "symmetry.h"
+#include "packedastar.h"
+#include "testfields.h"
+#include <unordered_map>
+#include <queue>
+#include <string>
+#include <iterator>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <stdlib.h>
+
+struct PlaceManhattan {
+    Cost operator()(const Field& f) const {
+        Cost sum = 0;
+        for(Field::const_iterator it = f.begin(); it != f.end(); ++it) {
+            if(it->occupied()) {
+                int value = it->tileMaybe.get().value - 1;
+                sum += abs(it->position.row - value/int(f.size)) + abs(it->position.column - value%int(f.size));
+            }
+        }
+        return sum;
+    }
+};
+
+TEST(Packed, shouldRoundTrip) {
+    Field f(4);
+    EXPECT_EQ(pack(f), packedGoal(4));
+    EXPECT_TRUE(unpack(pack(f), 4) == f);
+
+    PackedField p = randomWalk(3, 50);
+    EXPECT_EQ(pack(unpack(p, 3)), p);
+}
+
+TEST(Manhattan, shouldBeZeroAtGoal) {
+    for(unsigned size = 2; size <= MaxPackedSize; size++) {
+        EXPECT_EQ(manhattan(packedGoal(size), size), 0);
+        EXPECT_EQ(misplaced(packedGoal(size), size), 0);
+    }
+}
+
+TEST(Manhattan, kernelsShouldAgreeWithScalar) {
+    srand(26);
+
+    for(unsigned size = 2; size <= MaxPackedSize; size++) {
+        std::vector<PackedField> boards;
+        for(unsigned i = 0; i < 1001; i++) {
+            boards.push_back(randomWalk(size, 200));
+        }
+
+        std::vector<Cost> scalar(boards.size());
+        std::vector<Cost> dispatched(boards.size());
+
+        manhattanBatchScalar(&boards[0], &scalar[0], boards.size(), size);
+        manhattan(&boards[0], &dispatched[0], boards.size(), size);
+
+        for(unsigned i = 0; i < boards.size(); i++) {
+            ASSERT_EQ(scalar[i], PlaceManhattan()(unpack(boards[i], size)));
+            ASSERT_EQ(dispatched[i], scalar[i]);
+        }
+
+        if(__builtin_cpu_supports("ssse3")) {
+            std::vector<Cost> ssse3(boards.size());
+            manhattanBatchSsse3(&boards[0], &ssse3[0], boards.size(), size);
+            EXPECT_TRUE(ssse3 == scalar);
+
+            for(unsigned i = 0; i < boards.size(); i++) {
+                ASSERT_EQ(misplacedSsse3(boards[i], size), misplacedScalar(boards[i], size));
+            }
+        }
+
+        if(__builtin_cpu_supports("avx2")) {
+            std::vector<Cost> avx2(boards.size());
+            manhattanBatchAvx2(&boards[0], &avx2[0], boards.size(), size);
+            EXPECT_TRUE(avx2 == scalar);
+        }
+    }
+}
+
+/**
+ * @brief BFS from the goal over every reachable field of the given size
+ */
+void exhaustiveDistances(unsigned size, std::unordered_map<PackedField, Cost>& distances) {
+    std::queue<PackedField> frontier;
+
+    distances[packedGoal(size)] = 0;
+    frontier.push(packedGoal(size));
+
+    while(!frontier.empty()) {
+        PackedField p = frontier.front();
+        frontier.pop();
+
+        unsigned blank = blankAt(p, size);
+        Cost d = distances[p];
+
+        for(unsigned dir = Up; dir <= Right; dir++) {
+            unsigned to = neighbour(blank, static_cast<Direction>(dir), size);
+            if(to < size*size) {
+                PackedField next = slide(p, blank, to);
+                if(distances.insert(std::make_pair(next, d+1)).second) {
+                    frontier.push(next);
+                }
+            }
+        }
+    }
+}
+
+template<typename Heuristic>
+void expectAdmissibleAndConsistent(const Heuristic& h, unsigned size, const std::unordered_map<PackedField, Cost>& distances) {
+    for(std::unordered_map<PackedField, Cost>::const_iterator it = distances.begin(); it != distances.end(); ++it) {
+        Cost hs = h(it->first);
+        ASSERT_LE(hs, it->second);
+
+        unsigned blank = blankAt(it->first, size);
+        for(unsigned dir = Up; dir <= Right; dir++) {
+            unsigned to = neighbour(blank, static_cast<Direction>(dir), size);
+            if(to < size*size) {
+                ASSERT_LE(abs(hs - h(slide(it->first, blank, to))), 1);
+            }
+        }
+    }
+}
+
+struct ManhattanPlusConflicts {
+    Cost operator()(PackedField p) const {
+        return manhattan(p, 3) + linearConflictTables(3)(p);
+    }
+};
+
+TEST(HeuristicTables, shouldBeAdmissibleAndConsistentOnEveryEightPuzzle) {
+    std::unordered_map<PackedField, Cost> distances;
+    exhaustiveDistances(3, distances);
+    ASSERT_EQ(distances.size(), 181440u);
+
+    expectAdmissibleAndConsistent(ManhattanPlusConflicts(), 3, distances);
+    expectAdmissibleAndConsistent(walkingDistanceTable(3), 3, distances);
+}
+
+TEST(HeuristicTables, shouldDominateManhattan) {
+    srand(28);
+
+    for(unsigned i = 0; i < 1000; i++) {
+        PackedField p = randomWalk(4, 200);
+
+        EXPECT_GE(manhattan(p, 4) + linearConflictTables(4)(p), manhattan(p, 4));
+        EXPECT_GE(walkingDistanceTable(4)(p), 0);
+    }
+
+    EXPECT_EQ(walkingDistanceTable(4).states(), 24964u);
+    EXPECT_EQ(LinearConflictHeuristic()(Field(4)), 0);
+    EXPECT_EQ(WalkingDistanceHeuristic()(Field(4)), 0);
+}
+
+TEST(EightPuzzleOracle, shouldMatchExhaustiveDistancesAndSurviveSaving) {
+    std::unordered_map<PackedField, Cost> distances;
+    exhaustiveDistances(3, distances);
+
+    EightPuzzleOracle oracle;
+    oracle.generate();
+
+    EXPECT_EQ(oracle.reachable(), 181440u);
+    EXPECT_EQ(oracle.diameter(), 31u);
+
+    for(std::unordered_map<PackedField, Cost>::const_iterator it = distances.begin(); it != distances.end(); ++it) {
+        ASSERT_EQ(oracle.distance(it->first), unsigned(it->second));
+    }
+
+    const char* path = "eightoracle_test.bin";
+    ASSERT_TRUE(oracle.save(path));
+
+    EightPuzzleOracle loaded;
+    ASSERT_TRUE(loaded.load(path));
+
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // truncated, trailing byte, out of range distance, goal not at 0
+    std::vector<std::string> broken(4, bytes);
+    broken[0].resize(bytes.size()-1);
+    broken[1].push_back(0);
+    broken[2][8 + 1] = char(EightPuzzleOracle::Diameter + 1);
+    broken[3][8 + rankEight(packedGoal(3))] = 2;
+
+    for(size_t i = 0; i < broken.size(); i++) {
+        {
+            std::ofstream out(path, std::ios::binary);
+            out.write(broken[i].data(), broken[i].size());
+        }
+        EXPECT_FALSE(loaded.load(path));
+    }
+
+    for(std::unordered_map<PackedField, Cost>::const_iterator it = distances.begin(); it != distances.end(); ++it) {
+        ASSERT_EQ(loaded.distance(it->first), oracle.distance(it->first));
+    }
+
+    // a distance in range but inconsistent with the neighbours
+    PackedField p = distances.begin()->first;
+    unsigned far = oracle.distance(p) < 20 ? 30 : 2;
+    bytes[8 + rankEight(p)] = char(far);
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write(bytes.data(), bytes.size());
+    }
+    ASSERT_TRUE(loaded.load(path));
+    std::vector<Direction> moves;
+    EXPECT_FALSE(loaded.solve(p, moves));
+    EXPECT_TRUE(moves.empty());
+
+    remove(path);
+    EXPECT_FALSE(loaded.load(path));
+}
+
+TEST(Symmetry, mirrorShouldBeAnInvolutionFixingTheGoal) {
+    srand(39);
+
+    for(unsigned size = 2; size <= 5; size++) {
+        EXPECT_TRUE(mirror(Field(size)) == Field(size));
+        EXPECT_TRUE(canonical(Field(size)) == Field(size));
+    }
+
+    for(unsigned size = 2; size <= MaxPackedSize; size++) {
+        EXPECT_EQ(mirror(packedGoal(size), size), packedGoal(size));
+
+        for(unsigned i = 0; i < 100; i++) {
+            PackedField p = randomWalk(size, 100);
+            Field f = unpack(p, size);
+
+            EXPECT_EQ(mirror(mirror(p, size), size), p);
+            EXPECT_TRUE(mirror(f) == unpack(mirror(p, size), size));
+            EXPECT_TRUE(canonical(f) == canonical(mirror(f)));
+            EXPECT_EQ(canonical(p, size), canonical(mirror(p, size), size));
+
+            Cost h;
+            PackedMirroredMax<PackedManhattan>()(&p, &h, 1, size);
+            EXPECT_EQ(h, manhattan(p, size));
+        }
+    }
+}
+
+/**
+ * @brief Only the vertical part of the Manhattan distance, its mirror is the
+ *        horizontal part
+ */
+struct VerticalDistance: std::unary_function<const Field&, Cost> {
+    Cost operator()(const Field& f) const {
+        Cost sum = 0;
+        for(Field::const_iterator it = f.begin(); it != f.end(); ++it) {
+            if(it->occupied()) {
+                sum += abs(it->position.row - int(it->tileMaybe.get().value - 1)/int(f.size));
+            }
+        }
+        return sum;
+    }
+};
+
+TEST(Symmetry, mirrorShouldKeepDistancesAndStrengthenHeuristics) {
+    srand(39);
+
+    EightPuzzleOracle oracle;
+    oracle.generate();
+
+    MirroredMax<VerticalDistance> mirrored;
+    unsigned stronger = 0;
+
+    for(unsigned i = 0; i < 1000; i++) {
+        PackedField p = randomWalk(3, 100);
+        Field f = unpack(p, 3);
+
+        ASSERT_EQ(oracle.distance(mirror(p, 3)), oracle.distance(p));
+
+        Cost h = mirrored(f);
+        EXPECT_GE(h, VerticalDistance()(f));
+        EXPECT_LE(h, Cost(oracle.distance(p)));
+        stronger += h > VerticalDistance()(f);
+    }
+
+    EXPECT_GT(stronger, 100u);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
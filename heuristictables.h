@@ -0,0 +1,287 @@
+#ifndef HEURISTICTABLES_H
+#define HEURISTICTABLES_H
+
+#include "astar.h"
+#include "packed.h"
+#include "manhattan.h"
+#include <stdint.h>
+#include <vector>
+#include <queue>
+#include <unordered_map>
+#include <functional>
+
+/**
+ * @brief Extra moves forced by tiles sharing their goal line: for every row
+ *        (and every column) a table indexed by the packed contents of the line
+ *        holds 2*(tiles of the line - longest sequence of them already in
+ *        goal order), i.e. two moves per tile that has to leave the line.
+ */
+class LinearConflictTables {
+    unsigned size;
+    std::vector< std::vector<uint8_t> > rows;
+    std::vector< std::vector<uint8_t> > cols;
+
+    /**
+     * @brief `goals` are goal offsets (along the line) of tiles belonging to
+     *        the line in the order they stand in it
+     */
+    static uint8_t conflicts(const std::vector<unsigned>& goals) {
+        std::vector<unsigned> longest(goals.size(), 1);
+        unsigned best = 0;
+
+        for(size_t i = 0; i < goals.size(); i++) {
+            for(size_t j = 0; j < i; j++) {
+                if(goals[j] < goals[i]) {
+                    longest[i] = std::max(longest[i], longest[j]+1);
+                }
+            }
+            best = std::max(best, longest[i]);
+        }
+
+        return 2*(goals.size() - best);
+    }
+
+    void build(unsigned line, bool row, std::vector<uint8_t>& table) const {
+        table.assign(size_t(1) << (4*size), 0);
+
+        for(size_t contents = 0; contents < table.size(); contents++) {
+            std::vector<unsigned> goals;
+
+            for(unsigned i = 0; i < size; i++) {
+                unsigned tile = (contents >> (4*i)) & 0xF;
+                if(tile == 0 || tile >= size*size) {
+                    continue;
+                }
+
+                unsigned goalRow = (tile-1)/size;
+                unsigned goalCol = (tile-1)%size;
+
+                if(row && goalRow == line) {
+                    goals.push_back(goalCol);
+                }
+                if(!row && goalCol == line) {
+                    goals.push_back(goalRow);
+                }
+            }
+
+            table[contents] = conflicts(goals);
+        }
+    }
+
+public:
+    explicit LinearConflictTables(unsigned _size):
+        size(_size),
+        rows(_size),
+        cols(_size)
+    {
+        assert(size <= MaxPackedSize);
+
+        for(unsigned line = 0; line < size; line++) {
+            build(line, true, rows[line]);
+            build(line, false, cols[line]);
+        }
+    }
+
+    Cost operator()(PackedField p) const {
+        Cost sum = 0;
+        const PackedField lineMask = (PackedField(1) << (4*size)) - 1;
+
+        for(unsigned line = 0; line < size; line++) {
+            sum += rows[line][(p >> (4*size*line)) & lineMask];
+
+            size_t column = 0;
+            for(unsigned row = 0; row < size; row++) {
+                column |= size_t(tileAt(p, row*size+line)) << (4*row);
+            }
+            sum += cols[line][column];
+        }
+
+        return sum;
+    }
+};
+
+template<unsigned Size>
+const LinearConflictTables& linearConflictTablesOf() {
+    static const LinearConflictTables tables(Size);
+    return tables;
+}
+
+inline const LinearConflictTables& linearConflictTables(unsigned size) {
+    switch(size) {
+    case 2:
+        return linearConflictTablesOf<2>();
+    case 3:
+        return linearConflictTablesOf<3>();
+    default:
+        assert(size == 4);
+        return linearConflictTablesOf<4>();
+    }
+}
+
+/**
+ * @brief Walking distance: for every row `i` counts of tiles standing in it
+ *        whose goal row is `j` (3 bits each) form an abstract state, the
+ *        vacant place sits in the only row holding size-1 tiles. Moves of the
+ *        vacant place up and down carry one tile between neighbouring rows;
+ *        the table keeps the BFS distance of every abstract state to the goal
+ *        one. Columns are the same abstraction transposed.
+ */
+class WalkingDistanceTable {
+    unsigned size;
+    std::unordered_map<uint64_t, uint8_t> distances;
+
+    static unsigned count(uint64_t key, unsigned size, unsigned row, unsigned goal) {
+        return (key >> (3*(row*size+goal))) & 0x7;
+    }
+
+    static uint64_t add(uint64_t key, unsigned size, unsigned row, unsigned goal, unsigned tiles) {
+        return key + (uint64_t(tiles) << (3*(row*size+goal)));
+    }
+
+    static uint64_t remove(uint64_t key, unsigned size, unsigned row, unsigned goal) {
+        return key - (uint64_t(1) << (3*(row*size+goal)));
+    }
+
+    unsigned blankRow(uint64_t key) const {
+        for(unsigned row = 0; row < size; row++) {
+            unsigned tiles = 0;
+            for(unsigned goal = 0; goal < size; goal++) {
+                tiles += count(key, size, row, goal);
+            }
+            if(tiles < size) {
+                return row;
+            }
+        }
+
+        assert(false);
+        return size;
+    }
+
+public:
+    explicit WalkingDistanceTable(unsigned _size):
+        size(_size),
+        distances()
+    {
+        assert(size >= 2 && size <= MaxPackedSize);
+
+        uint64_t goal = 0;
+        for(unsigned row = 0; row < size; row++) {
+            goal = add(goal, size, row, row, row+1 < size ? size : size-1);
+        }
+
+        std::queue<uint64_t> frontier;
+        distances[goal] = 0;
+        frontier.push(goal);
+
+        while(!frontier.empty()) {
+            uint64_t key = frontier.front();
+            frontier.pop();
+
+            const uint8_t d = distances[key];
+            const unsigned blank = blankRow(key);
+
+            for(int step = -1; step <= 1; step += 2) {
+                if((step < 0 && blank == 0) || (step > 0 && blank+1 == size)) {
+                    continue;
+                }
+                unsigned from = blank+step;
+
+                for(unsigned g = 0; g < size; g++) {
+                    if(count(key, size, from, g) == 0) {
+                        continue;
+                    }
+
+                    uint64_t next = add(remove(key, size, from, g), size, blank, g, 1);
+                    if(distances.find(next) == distances.end()) {
+                        distances[next] = d+1;
+                        frontier.push(next);
+                    }
+                }
+            }
+        }
+    }
+
+    size_t states() const {
+        return distances.size();
+    }
+
+    Cost operator()(PackedField p) const {
+        uint64_t rows = 0;
+        uint64_t cols = 0;
+
+        for(unsigned cell = 0; cell < size*size; cell++) {
+            unsigned tile = tileAt(p, cell);
+            if(tile == 0) {
+                continue;
+            }
+
+            rows = add(rows, size, cell/size, (tile-1)/size, 1);
+            cols = add(cols, size, cell%size, (tile-1)%size, 1);
+        }
+
+        std::unordered_map<uint64_t, uint8_t>::const_iterator vertical = distances.find(rows);
+        std::unordered_map<uint64_t, uint8_t>::const_iterator horizontal = distances.find(cols);
+        assert(vertical != distances.end() && horizontal != distances.end());
+
+        return vertical->second + horizontal->second;
+    }
+};
+
+template<unsigned Size>
+const WalkingDistanceTable& walkingDistanceTableOf() {
+    static const WalkingDistanceTable table(Size);
+    return table;
+}
+
+inline const WalkingDistanceTable& walkingDistanceTable(unsigned size) {
+    switch(size) {
+    case 2:
+        return walkingDistanceTableOf<2>();
+    case 3:
+        return walkingDistanceTableOf<3>();
+    default:
+        assert(size == 4);
+        return walkingDistanceTableOf<4>();
+    }
+}
+
+/**
+ * @brief Manhattan distance plus linear conflicts
+ */
+struct LinearConflictHeuristic: std::unary_function<const Field&, Cost> {
+    Cost operator ()(const Field& f) const {
+        PackedField p = pack(f);
+        return manhattan(p, f.size) + linearConflictTables(f.size)(p);
+    }
+};
+
+struct WalkingDistanceHeuristic: std::unary_function<const Field&, Cost> {
+    Cost operator ()(const Field& f) const {
+        return walkingDistanceTable(f.size)(pack(f));
+    }
+};
+
+/**
+ * @brief Batch counterparts to be plugged into PackedAStar
+ */
+struct PackedLinearConflict {
+    void operator()(const PackedField* fields, Cost* costs, size_t count, unsigned size) const {
+        manhattan(fields, costs, count, size);
+
+        const LinearConflictTables& tables = linearConflictTables(size);
+        for(size_t i = 0; i < count; i++) {
+            costs[i] += tables(fields[i]);
+        }
+    }
+};
+
+struct PackedWalkingDistance {
+    void operator()(const PackedField* fields, Cost* costs, size_t count, unsigned size) const {
+        const WalkingDistanceTable& table = walkingDistanceTable(size);
+        for(size_t i = 0; i < count; i++) {
+            costs[i] = table(fields[i]);
+        }
+    }
+};
+
+#endif // HEURISTICTABLES_H
@@ -0,0 +1,384 @@
+#ifndef IDASTAR_H
+#define IDASTAR_H
+
+#include "packed.h"
+#include "packedastar.h"
+#include "movepruning.h"
+#include <stdint.h>
+#include <limits.h>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <boost/utility.hpp>
+
+namespace ida {
+
+enum {
+    Found = -1,
+    Unbounded = INT_MAX,
+    NoMove = 4
+};
+
+/**
+ * @brief Depth-first walk of IDA* under a bound, Manhattan distance updated
+ *        per move from an OperatorTable. Moves are pruned by `automaton` if
+ *        given, otherwise only moves undoing the previous one are.
+ */
+class Walker {
+    const unsigned size;
+    const PackedField goal;
+    const OperatorTable<PackedManhattan>& operators;
+    const MoveAutomaton* automaton;
+    const std::atomic<bool>* stop;
+
+public:
+    std::vector<Direction> path;
+    size_t expanded;
+
+    Walker(unsigned _size, const OperatorTable<PackedManhattan>& _operators, const MoveAutomaton* _automaton, const std::atomic<bool>* _stop = 0):
+        size(_size),
+        goal(packedGoal(_size)),
+        operators(_operators),
+        automaton(_automaton),
+        stop(_stop),
+        path(),
+        expanded(0)
+    {}
+
+    /**
+     * @brief Found with the solution in `path`, or the least f above `bound`
+     */
+    Cost search(PackedField p, unsigned blank, Cost g, Cost h, Cost bound, int state, unsigned last) {
+        if(g + h > bound) {
+            return g + h;
+        }
+        if(p == goal) {
+            return Found;
+        }
+        if(stop != 0 && stop->load(std::memory_order_relaxed)) {
+            return Unbounded;
+        }
+
+        expanded++;
+
+        Cost next = Unbounded;
+        for(unsigned d = Up; d <= Right; d++) {
+            int following = state;
+            if(automaton != 0) {
+                following = automaton->next(state, static_cast<Direction>(d));
+                if(following == MoveAutomaton::Pruned) {
+                    continue;
+                }
+            } else if(last != NoMove && d == inverse(static_cast<Direction>(last))) {
+                continue;
+            }
+
+            unsigned to = neighbour(blank, static_cast<Direction>(d), size);
+            if(to >= size*size) {
+                continue;
+            }
+
+            path.push_back(static_cast<Direction>(d));
+            Cost t = search(slide(p, blank, to), to, g+1, h + operators.delta(p, to, blank), bound, following, d);
+            if(t == Found) {
+                return Found;
+            }
+            path.pop_back();
+
+            next = std::min(next, t);
+        }
+
+        return next;
+    }
+};
+
+}
+
+/**
+ * @brief IDA* over packed fields (up to 4x4) towards Field(size) with the
+ *        Manhattan distance, optionally pruning moves by a MoveAutomaton
+ */
+class PackedIDAStar: public boost::noncopyable
+{
+    const unsigned size;
+    const OperatorTable<PackedManhattan> operators;
+    const MoveAutomaton* automaton;
+    size_t expandedCount;
+
+public:
+
+    PackedIDAStar(unsigned _size, const MoveAutomaton* _automaton = 0):
+        size(_size),
+        operators(_size),
+        automaton(_automaton),
+        expandedCount(0)
+    {
+        assert(size <= MaxPackedSize);
+    }
+
+    bool plan(PackedField initial, std::vector<Direction>& moves) {
+        ida::Walker walker(size, operators, automaton);
+
+        const unsigned blank = blankAt(initial, size);
+        const Cost h = manhattan(initial, size);
+
+        Cost bound = h;
+        Cost t;
+        while((t = walker.search(initial, blank, 0, h, bound, MoveAutomaton::Start, ida::NoMove)) != ida::Found) {
+            if(t == ida::Unbounded) {
+                expandedCount = walker.expanded;
+                return false;
+            }
+            bound = t;
+        }
+
+        expandedCount = walker.expanded;
+        moves = walker.path;
+        return true;
+    }
+
+    size_t expanded() const {
+        return expandedCount;
+    }
+};
+
+/**
+ * @brief IDA* of PackedIDAStar run by several threads.
+ *
+ * The top of the tree is expanded breadth first into work units (at least
+ * `unitsPerThread` per thread), then every iteration deals them to per-thread
+ * deques: a thread takes units from the back of its own deque and steals from
+ * the front of others when it runs dry. Threads share the next bound, and the
+ * first one to find a solution (optimal, as it is found under the least
+ * bound that admits one) stops the others.
+ */
+class ParallelIDAStar: public boost::noncopyable
+{
+    struct Unit {
+        PackedField state;
+        uint8_t blank;
+        uint8_t last;
+        Cost g;
+        Cost h;
+        int automatonState;
+        std::vector<Direction> prefix;
+    };
+
+    struct WorkQueue {
+        std::mutex lock;
+        std::deque<size_t> units;
+    };
+
+    const unsigned size;
+    const unsigned threads;
+    const size_t unitsPerThread;
+    const OperatorTable<PackedManhattan> operators;
+    const MoveAutomaton* automaton;
+
+    std::vector<Unit> units;
+    std::vector< std::unique_ptr<WorkQueue> > queues;
+    std::atomic<size_t> expandedCount;
+    std::atomic<size_t> stolenCount;
+
+    /**
+     * @brief Expands the top of the tree level by level into `units`, true
+     *        if the goal is met on the way (with its moves in `moves`)
+     */
+    bool split(PackedField initial, std::vector<Direction>& moves) {
+        Unit root;
+        root.state = initial;
+        root.blank = blankAt(initial, size);
+        root.last = ida::NoMove;
+        root.g = 0;
+        root.h = manhattan(initial, size);
+        root.automatonState = MoveAutomaton::Start;
+
+        units.assign(1, root);
+
+        const PackedField goal = packedGoal(size);
+        while(units.size() < threads*unitsPerThread) {
+            std::vector<Unit> level;
+
+            for(size_t i = 0; i < units.size(); i++) {
+                const Unit& u = units[i];
+                if(u.state == goal) {
+                    moves = u.prefix;
+                    return true;
+                }
+
+                for(unsigned d = Up; d <= Right; d++) {
+                    int following = u.automatonState;
+                    if(automaton != 0) {
+                        following = automaton->next(u.automatonState, static_cast<Direction>(d));
+                        if(following == MoveAutomaton::Pruned) {
+                            continue;
+                        }
+                    } else if(u.last != ida::NoMove && d == inverse(static_cast<Direction>(u.last))) {
+                        continue;
+                    }
+
+                    unsigned to = neighbour(u.blank, static_cast<Direction>(d), size);
+                    if(to >= size*size) {
+                        continue;
+                    }
+
+                    Unit child;
+                    child.state = slide(u.state, u.blank, to);
+                    child.blank = to;
+                    child.last = d;
+                    child.g = u.g+1;
+                    child.h = u.h + operators.delta(u.state, to, u.blank);
+                    child.automatonState = following;
+                    child.prefix = u.prefix;
+                    child.prefix.push_back(static_cast<Direction>(d));
+
+                    level.push_back(child);
+                }
+            }
+
+            if(level.empty()) {
+                break;
+            }
+            units.swap(level);
+        }
+
+        return false;
+    }
+
+    bool take(unsigned self, size_t& unit) {
+        {
+            WorkQueue& own = *queues[self];
+            std::lock_guard<std::mutex> guard(own.lock);
+            if(!own.units.empty()) {
+                unit = own.units.back();
+                own.units.pop_back();
+                return true;
+            }
+        }
+
+        for(unsigned i = 1; i < threads; i++) {
+            WorkQueue& other = *queues[(self+i) % threads];
+            std::lock_guard<std::mutex> guard(other.lock);
+            if(!other.units.empty()) {
+                unit = other.units.front();
+                other.units.pop_front();
+                stolenCount++;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    static void lower(std::atomic<Cost>& bound, Cost value) {
+        Cost current = bound.load();
+        while(value < current && !bound.compare_exchange_weak(current, value)) {
+        }
+    }
+
+    void work(unsigned self, Cost bound, std::atomic<bool>& found, std::atomic<Cost>& nextBound,
+              std::mutex& solutionLock, std::vector<Direction>& solution) {
+
+        ida::Walker walker(size, operators, automaton, &found);
+
+        size_t unit;
+        while(!found.load(std::memory_order_relaxed) && take(self, unit)) {
+            const Unit& u = units[unit];
+
+            walker.path = u.prefix;
+            Cost t = walker.search(u.state, u.blank, u.g, u.h, bound, u.automatonState, u.last);
+
+            if(t == ida::Found) {
+                std::lock_guard<std::mutex> guard(solutionLock);
+                if(!found.exchange(true)) {
+                    solution = walker.path;
+                }
+            } else {
+                lower(nextBound, t);
+            }
+        }
+
+        expandedCount += walker.expanded;
+    }
+
+public:
+
+    ParallelIDAStar(unsigned _size, unsigned _threads = std::thread::hardware_concurrency(),
+                    const MoveAutomaton* _automaton = 0, size_t _unitsPerThread = 64):
+        size(_size),
+        threads(std::max(1u, _threads)),
+        unitsPerThread(_unitsPerThread),
+        operators(_size),
+        automaton(_automaton),
+        units(),
+        queues(),
+        expandedCount(0),
+        stolenCount(0)
+    {
+        assert(size <= MaxPackedSize);
+
+        for(unsigned t = 0; t < threads; t++) {
+            queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+        }
+    }
+
+    bool plan(PackedField initial, std::vector<Direction>& moves) {
+        expandedCount = 0;
+        stolenCount = 0;
+
+        if(split(initial, moves)) {
+            return true;
+        }
+
+        Cost bound = manhattan(initial, size);
+        for(;;) {
+            for(size_t i = 0; i < units.size(); i++) {
+                queues[i % threads]->units.push_back(i);
+            }
+
+            std::atomic<bool> found(false);
+            std::atomic<Cost> nextBound(ida::Unbounded);
+            std::mutex solutionLock;
+            std::vector<Direction> solution;
+
+            std::vector<std::thread> workers;
+            for(unsigned t = 0; t < threads; t++) {
+                workers.push_back(std::thread(&ParallelIDAStar::work, this, t, bound,
+                                              std::ref(found), std::ref(nextBound), std::ref(solutionLock), std::ref(solution)));
+            }
+            for(unsigned t = 0; t < threads; t++) {
+                workers[t].join();
+            }
+
+            if(found) {
+                for(unsigned t = 0; t < threads; t++) {
+                    queues[t]->units.clear();
+                }
+
+                moves.swap(solution);
+                return true;
+            }
+
+            if(nextBound == ida::Unbounded) {
+                return false;
+            }
+            bound = nextBound;
+        }
+    }
+
+    size_t expanded() const {
+        return expandedCount;
+    }
+
+    /**
+     * @brief Units taken from another thread's deque during the last plan()
+     */
+    size_t stolen() const {
+        return stolenCount;
+    }
+};
+
+#endif // IDASTAR_H
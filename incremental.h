@@ -0,0 +1,332 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include "astar.h"
+#include "packed.h"
+#include "packedastar.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+#include <queue>
+#include <utility>
+#include <unordered_map>
+#include <boost/utility.hpp>
+
+/**
+ * @brief Manhattan distance between two arbitrary fields of the same size
+ */
+class PairwiseManhattan {
+    unsigned size;
+    int row[16];
+    int col[16];
+
+public:
+    PairwiseManhattan(PackedField target, unsigned _size):
+        size(_size)
+    {
+        for(unsigned cell = 0; cell < size*size; cell++) {
+            row[tileAt(target, cell)] = cell/size;
+            col[tileAt(target, cell)] = cell%size;
+        }
+    }
+
+    Cost operator()(PackedField p) const {
+        Cost sum = 0;
+        for(unsigned cell = 0; cell < size*size; cell++) {
+            unsigned tile = tileAt(p, cell);
+            if(tile != 0) {
+                sum += abs(int(cell/size) - row[tile]) + abs(int(cell%size) - col[tile]);
+            }
+        }
+
+        return sum;
+    }
+};
+
+/**
+ * @brief D* Lite towards Field(size): the search runs backwards from the goal
+ *        and keeps g/rhs of every field it touched between calls, so after the
+ *        start moved (or some move costs changed) only the inconsistent part
+ *        is repaired instead of searching from scratch.
+ */
+template<typename EdgeCost = UnitMoveCost>
+class PackedDStarLite: public boost::noncopyable
+{
+public:
+    enum { Blocked = 1 << 29 };
+
+private:
+    typedef std::pair<Cost, Cost> Key;
+
+    struct Vertex {
+        Cost g;
+        Cost rhs;
+        bool open;
+        Key key;
+
+        Vertex():
+            g(Blocked),
+            rhs(Blocked),
+            open(false),
+            key(Blocked, Blocked)
+        {}
+    };
+
+    typedef std::pair<Key, PackedField> QueueEntry;
+
+    const unsigned size;
+    const PackedField goal;
+    EdgeCost cost;
+
+    std::unordered_map<PackedField, Vertex> vertices;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry> > queue;
+
+    bool started;
+    PackedField start;
+    PairwiseManhattan heuristic;
+    Cost km;
+
+    size_t expandedCount;
+
+    static Cost add(Cost a, Cost b) {
+        return std::min<Cost>(Blocked, a+b);
+    }
+
+    Vertex& vertex(PackedField p) {
+        return vertices[p];
+    }
+
+    Key calculateKey(PackedField p) {
+        const Vertex& v = vertex(p);
+        Cost m = std::min(v.g, v.rhs);
+
+        return Key(add(add(m, heuristic(p)), km), m);
+    }
+
+    void neighbours(PackedField p, std::vector<PackedField>& out) const {
+        out.clear();
+
+        unsigned blank = blankAt(p, size);
+        for(unsigned d = Up; d <= Right; d++) {
+            unsigned to = neighbour(blank, static_cast<Direction>(d), size);
+            if(to < size*size) {
+                out.push_back(slide(p, blank, to));
+            }
+        }
+    }
+
+    void enqueue(PackedField p) {
+        Vertex& v = vertex(p);
+        v.open = true;
+        v.key = calculateKey(p);
+        queue.push(QueueEntry(v.key, p));
+    }
+
+    /**
+     * @brief Drops queue entries of fields left consistent or re-keyed since
+     */
+    void discardStale() {
+        while(!queue.empty()) {
+            const QueueEntry& top = queue.top();
+            const Vertex& v = vertex(top.second);
+
+            if(v.open && v.key == top.first) {
+                return;
+            }
+            queue.pop();
+        }
+    }
+
+    Cost bestSuccessor(PackedField p) {
+        std::vector<PackedField> next;
+        neighbours(p, next);
+
+        Cost best = Blocked;
+        for(size_t i = 0; i < next.size(); i++) {
+            best = std::min(best, add(cost(p, next[i]), vertex(next[i]).g));
+        }
+
+        return best;
+    }
+
+    void updateVertex(PackedField p) {
+        Vertex& v = vertex(p);
+
+        if(v.g != v.rhs) {
+            enqueue(p);
+        } else {
+            v.open = false;
+        }
+    }
+
+    void computeShortestPath() {
+        std::vector<PackedField> around;
+
+        for(;;) {
+            discardStale();
+
+            Key startKey = calculateKey(start);
+            const Vertex& s = vertex(start);
+            if(queue.empty() || (!(queue.top().first < startKey) && s.rhs == s.g)) {
+                return;
+            }
+
+            const PackedField u = queue.top().second;
+            const Key old = queue.top().first;
+            const Key fresh = calculateKey(u);
+            Vertex& vu = vertex(u);
+
+            if(old < fresh) {
+                vu.key = fresh;
+                queue.push(QueueEntry(fresh, u));
+                continue;
+            }
+
+            expandedCount++;
+            neighbours(u, around);
+
+            if(vu.g > vu.rhs) {
+                vu.g = vu.rhs;
+                vu.open = false;
+
+                for(size_t i = 0; i < around.size(); i++) {
+                    Vertex& vp = vertex(around[i]);
+                    if(around[i] != goal) {
+                        vp.rhs = std::min(vp.rhs, add(cost(around[i], u), vertex(u).g));
+                    }
+                    updateVertex(around[i]);
+                }
+            } else {
+                const Cost previous = vu.g;
+                vu.g = Blocked;
+
+                around.push_back(u);
+                for(size_t i = 0; i < around.size(); i++) {
+                    const PackedField p = around[i];
+                    Vertex& vp = vertex(p);
+
+                    bool through = p == u || vp.rhs == add(cost(p, u), previous);
+                    if(through && p != goal) {
+                        vp.rhs = bestSuccessor(p);
+                    }
+                    updateVertex(p);
+                }
+            }
+        }
+    }
+
+    void moveStart(PackedField to) {
+        if(!started) {
+            started = true;
+            start = to;
+            heuristic = PairwiseManhattan(start, size);
+            return;
+        }
+
+        if(to == start) {
+            return;
+        }
+
+        km += heuristic(to);
+        start = to;
+        heuristic = PairwiseManhattan(start, size);
+    }
+
+public:
+
+    PackedDStarLite(unsigned _size, const EdgeCost& _cost = EdgeCost()):
+        size(_size),
+        goal(packedGoal(_size)),
+        cost(_cost),
+        vertices(),
+        queue(),
+        started(false),
+        start(goal),
+        heuristic(goal, _size),
+        km(0),
+        expandedCount(0)
+    {
+        assert(size <= MaxPackedSize);
+
+        vertex(goal).rhs = 0;
+        enqueue(goal);
+    }
+
+    /**
+     * @brief (Re)plans from `initial`, reusing everything computed before
+     */
+    bool plan(PackedField initial, std::vector<Direction>& moves) {
+        moveStart(initial);
+        expandedCount = 0;
+
+        computeShortestPath();
+
+        moves.clear();
+        if(vertex(start).g >= Blocked) {
+            return false;
+        }
+
+        PackedField p = start;
+        while(p != goal) {
+            unsigned blank = blankAt(p, size);
+
+            Cost best = Blocked;
+            Direction bestMove = Up;
+            PackedField bestNext = p;
+
+            for(unsigned d = Up; d <= Right; d++) {
+                unsigned to = neighbour(blank, static_cast<Direction>(d), size);
+                if(to >= size*size) {
+                    continue;
+                }
+
+                PackedField next = slide(p, blank, to);
+                Cost through = add(cost(p, next), vertex(next).g);
+                if(through < best) {
+                    best = through;
+                    bestMove = static_cast<Direction>(d);
+                    bestNext = next;
+                }
+            }
+
+            assert(best < Blocked);
+            moves.push_back(bestMove);
+            p = bestNext;
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief To be called after the cost of moving between `from` and `to`
+     *        (in any direction) has changed
+     */
+    void costChanged(PackedField from, PackedField to) {
+        if(from != goal) {
+            vertex(from).rhs = bestSuccessor(from);
+        }
+        updateVertex(from);
+
+        if(to != goal) {
+            vertex(to).rhs = bestSuccessor(to);
+        }
+        updateVertex(to);
+    }
+
+    EdgeCost& edgeCost() {
+        return cost;
+    }
+
+    /**
+     * @brief Fields expanded by the last plan()
+     */
+    size_t expanded() const {
+        return expandedCount;
+    }
+
+    size_t fields() const {
+        return vertices.size();
+    }
+};
+
+#endif // INCREMENTAL_H
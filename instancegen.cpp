@@ -0,0 +1,138 @@
+#include "generator.h"
+#include "binaryio.h"
+#include "eightoracle.h"
+#include <iostream>
+#include <string>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Text format: one instance per line, tiles in place order separated by
+ * spaces, 0 for the vacant place.
+ */
+void writeText(std::ostream& os, const std::vector<unsigned>& tiles, std::string& line) {
+    line.clear();
+    for(size_t cell = 0; cell < tiles.size(); cell++) {
+        if(cell > 0) {
+            line += ' ';
+        }
+        if(tiles[cell] >= 100) {
+            line += char('0' + tiles[cell]/100);
+        }
+        if(tiles[cell] >= 10) {
+            line += char('0' + tiles[cell]/10%10);
+        }
+        line += char('0' + tiles[cell]%10);
+    }
+    line += '\n';
+
+    os.write(line.data(), line.size());
+}
+
+int usage(const char* name) {
+    std::cerr<<"usage: "<<name<<" <size> <count> [--seed n] [--walk length] [--manhattan min max]"
+             <<" [--exact min max (3x3 only)] [--attempts per instance] [--binary]"<<std::endl;
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    if(argc < 3) {
+        return usage(argv[0]);
+    }
+
+    const unsigned size = atoi(argv[1]);
+    const size_t count = strtoull(argv[2], 0, 10);
+
+    uint64_t seed = 1;
+    bool walk = false;
+    unsigned length = 0;
+    unsigned minManhattan = 0;
+    unsigned maxManhattan = ~0u;
+    bool exact = false;
+    unsigned minExact = 0;
+    unsigned maxExact = ~0u;
+    unsigned attempts = 1 << 20;
+    bool binary = false;
+
+    for(int i = 3; i < argc; i++) {
+        std::string option = argv[i];
+
+        if(option == "--seed" && i+1 < argc) {
+            seed = strtoull(argv[++i], 0, 10);
+        } else if(option == "--walk" && i+1 < argc) {
+            walk = true;
+            length = atoi(argv[++i]);
+        } else if(option == "--manhattan" && i+2 < argc) {
+            minManhattan = atoi(argv[++i]);
+            maxManhattan = atoi(argv[++i]);
+        } else if(option == "--exact" && i+2 < argc && size == 3) {
+            exact = true;
+            minExact = atoi(argv[++i]);
+            maxExact = atoi(argv[++i]);
+        } else if(option == "--attempts" && i+1 < argc) {
+            attempts = atoi(argv[++i]);
+        } else if(option == "--binary") {
+            binary = true;
+        } else {
+            return usage(argv[0]);
+        }
+    }
+
+    if(size < 2 || size*size > 256 || attempts == 0) {
+        return usage(argv[0]);
+    }
+    if(minManhattan > maxManhattan || (exact && (minExact > maxExact || minExact > EightPuzzleOracle::Diameter))) {
+        std::cerr<<"no instance can be in the band given"<<std::endl;
+        return 1;
+    }
+
+    EightPuzzleOracle oracle;
+    if(exact) {
+        oracle.generate();
+    }
+
+    std::ios_base::sync_with_stdio(false);
+
+    InstanceGenerator generator(size, seed);
+    BinaryWriter* writer = binary ? new BinaryWriter(std::cout, size) : 0;
+
+    std::vector<unsigned> tiles;
+    std::string line;
+    unsigned tried = 0;
+    for(size_t written = 0; written < count; ) {
+        if(tried == attempts) {
+            std::cerr<<"no instance in the band after "<<attempts<<" attempts, "<<written<<" written"<<std::endl;
+            delete writer;
+            return 1;
+        }
+        tried++;
+
+        if(walk) {
+            generator.walk(length, tiles);
+        } else {
+            generator.uniform(tiles);
+        }
+
+        unsigned h = generator::manhattan(tiles, size);
+        if(h < minManhattan || h > maxManhattan) {
+            continue;
+        }
+        if(exact) {
+            unsigned distance = oracle.distance(generator::pack(tiles));
+            if(distance < minExact || distance > maxExact) {
+                continue;
+            }
+        }
+
+        if(writer != 0) {
+            writer->write(tiles, std::vector<Direction>());
+        } else {
+            writeText(std::cout, tiles, line);
+        }
+        written++;
+        tried = 0;
+    }
+
+    delete writer;
+    return std::cout.good() ? 0 : 1;
+}
@@ -0,0 +1,242 @@
+#ifndef MANHATTAN_H
+#define MANHATTAN_H
+
+#include "packed.h"
+#include "astar.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <functional>
+#include <immintrin.h>
+
+/**
+ * @brief Lookup tables indexed by tile (goalRow, goalCol, goalCell) and by
+ *        cell (cellRow, cellCol, cellIndex). Entries of the vacant place and
+ *        of cells outside of a board smaller than 4x4 are zero.
+ */
+struct ManhattanTables {
+    unsigned size;
+
+    alignas(16) uint8_t goalRow[16];
+    alignas(16) uint8_t goalCol[16];
+    alignas(16) uint8_t goalCell[16];
+    alignas(16) uint8_t cellRow[16];
+    alignas(16) uint8_t cellCol[16];
+    alignas(16) uint8_t cellIndex[16];
+
+    explicit ManhattanTables(unsigned _size):
+        size(_size)
+    {
+        assert(size <= MaxPackedSize);
+
+        for(unsigned i = 0; i < 16; i++) {
+            goalRow[i] = goalCol[i] = goalCell[i] = 0;
+            cellRow[i] = cellCol[i] = cellIndex[i] = 0;
+        }
+
+        for(unsigned cell = 0; cell < size*size; cell++) {
+            cellRow[cell] = cell/size;
+            cellCol[cell] = cell%size;
+            cellIndex[cell] = cell;
+        }
+
+        for(unsigned tile = 1; tile < size*size; tile++) {
+            goalRow[tile] = (tile-1)/size;
+            goalCol[tile] = (tile-1)%size;
+            goalCell[tile] = tile-1;
+        }
+    }
+};
+
+inline const ManhattanTables& manhattanTables(unsigned size) {
+    static const ManhattanTables tables[MaxPackedSize+1] = {
+        ManhattanTables(0),
+        ManhattanTables(1),
+        ManhattanTables(2),
+        ManhattanTables(3),
+        ManhattanTables(4)
+    };
+
+    assert(size <= MaxPackedSize);
+    return tables[size];
+}
+
+inline Cost manhattanScalar(PackedField p, unsigned size) {
+    const ManhattanTables& t = manhattanTables(size);
+
+    Cost sum = 0;
+    for(unsigned cell = 0; cell < size*size; cell++) {
+        unsigned tile = tileAt(p, cell);
+        if(tile != 0) {
+            sum += abs(int(t.cellRow[cell]) - t.goalRow[tile]) + abs(int(t.cellCol[cell]) - t.goalCol[tile]);
+        }
+    }
+
+    return sum;
+}
+
+inline Cost misplacedScalar(PackedField p, unsigned size) {
+    Cost count = 0;
+    for(unsigned cell = 0; cell < size*size; cell++) {
+        unsigned tile = tileAt(p, cell);
+        if(tile != 0 && tile != cell+1) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * @brief Spreads 16 nibbles of a packed board to 16 bytes, byte i being the
+ *        tile at cell i
+ */
+__attribute__((target("ssse3")))
+inline __m128i unpackNibbles(PackedField p) {
+    const __m128i packed = _mm_cvtsi64_si128(static_cast<long long>(p));
+    const __m128i low = _mm_set1_epi8(0x0F);
+
+    return _mm_unpacklo_epi8(
+                _mm_and_si128(packed, low),
+                _mm_and_si128(_mm_srli_epi64(packed, 4), low)
+                );
+}
+
+__attribute__((target("ssse3")))
+inline Cost manhattanSsse3(PackedField p, unsigned size) {
+    const ManhattanTables& t = manhattanTables(size);
+    const __m128i tiles = unpackNibbles(p);
+    const __m128i zero = _mm_setzero_si128();
+
+    __m128i rows = _mm_abs_epi8(_mm_sub_epi8(
+                _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(t.goalRow)), tiles),
+                _mm_load_si128(reinterpret_cast<const __m128i*>(t.cellRow))));
+    __m128i cols = _mm_abs_epi8(_mm_sub_epi8(
+                _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(t.goalCol)), tiles),
+                _mm_load_si128(reinterpret_cast<const __m128i*>(t.cellCol))));
+
+    __m128i distances = _mm_andnot_si128(_mm_cmpeq_epi8(tiles, zero), _mm_add_epi8(rows, cols));
+    __m128i sums = _mm_sad_epu8(distances, zero);
+
+    return _mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4);
+}
+
+__attribute__((target("ssse3,popcnt")))
+inline Cost misplacedSsse3(PackedField p, unsigned size) {
+    const ManhattanTables& t = manhattanTables(size);
+    const __m128i tiles = unpackNibbles(p);
+
+    __m128i atPlace = _mm_or_si128(
+                _mm_cmpeq_epi8(
+                    _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(t.goalCell)), tiles),
+                    _mm_load_si128(reinterpret_cast<const __m128i*>(t.cellIndex))),
+                _mm_cmpeq_epi8(tiles, _mm_setzero_si128()));
+
+    return __builtin_popcount(~_mm_movemask_epi8(atPlace) & 0xFFFF);
+}
+
+/**
+ * @brief Evaluates two boards per iteration, one in each 128 bit lane
+ */
+__attribute__((target("avx2")))
+inline void manhattanBatchAvx2(const PackedField* boards, Cost* costs, size_t count, unsigned size) {
+    const ManhattanTables& t = manhattanTables(size);
+
+    const __m256i goalRow = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(t.goalRow)));
+    const __m256i goalCol = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(t.goalCol)));
+    const __m256i cellRow = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(t.cellRow)));
+    const __m256i cellCol = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(t.cellCol)));
+    const __m256i zero = _mm256_setzero_si256();
+
+    size_t i = 0;
+    for(; i+2 <= count; i += 2) {
+        __m256i tiles = _mm256_inserti128_si256(
+                    _mm256_castsi128_si256(unpackNibbles(boards[i])),
+                    unpackNibbles(boards[i+1]),
+                    1);
+
+        __m256i rows = _mm256_abs_epi8(_mm256_sub_epi8(_mm256_shuffle_epi8(goalRow, tiles), cellRow));
+        __m256i cols = _mm256_abs_epi8(_mm256_sub_epi8(_mm256_shuffle_epi8(goalCol, tiles), cellCol));
+        __m256i distances = _mm256_andnot_si256(_mm256_cmpeq_epi8(tiles, zero), _mm256_add_epi8(rows, cols));
+        __m256i sums = _mm256_sad_epu8(distances, zero);
+
+        costs[i] = _mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1);
+        costs[i+1] = _mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3);
+    }
+
+    for(; i < count; i++) {
+        costs[i] = manhattanSsse3(boards[i], size);
+    }
+}
+
+inline void manhattanBatchScalar(const PackedField* boards, Cost* costs, size_t count, unsigned size) {
+    for(size_t i = 0; i < count; i++) {
+        costs[i] = manhattanScalar(boards[i], size);
+    }
+}
+
+inline void manhattanBatchSsse3(const PackedField* boards, Cost* costs, size_t count, unsigned size) {
+    for(size_t i = 0; i < count; i++) {
+        costs[i] = manhattanSsse3(boards[i], size);
+    }
+}
+
+/**
+ * @brief Kernels picked once according to what the running CPU supports
+ */
+struct ManhattanKernels {
+    Cost (*manhattan)(PackedField, unsigned);
+    Cost (*misplaced)(PackedField, unsigned);
+    void (*manhattanBatch)(const PackedField*, Cost*, size_t, unsigned);
+
+    ManhattanKernels():
+        manhattan(&manhattanScalar),
+        misplaced(&misplacedScalar),
+        manhattanBatch(&manhattanBatchScalar)
+    {
+        __builtin_cpu_init();
+
+        if(__builtin_cpu_supports("ssse3") && __builtin_cpu_supports("popcnt")) {
+            manhattan = &manhattanSsse3;
+            misplaced = &misplacedSsse3;
+            manhattanBatch = &manhattanBatchSsse3;
+        }
+
+        if(__builtin_cpu_supports("avx2")) {
+            manhattanBatch = &manhattanBatchAvx2;
+        }
+    }
+};
+
+inline const ManhattanKernels& manhattanKernels() {
+    static const ManhattanKernels kernels;
+    return kernels;
+}
+
+inline Cost manhattan(PackedField p, unsigned size) {
+    return manhattanKernels().manhattan(p, size);
+}
+
+inline Cost misplaced(PackedField p, unsigned size) {
+    return manhattanKernels().misplaced(p, size);
+}
+
+inline void manhattan(const PackedField* boards, Cost* costs, size_t count, unsigned size) {
+    manhattanKernels().manhattanBatch(boards, costs, count, size);
+}
+
+/**
+ * @brief Drop-in replacement of per-place Manhattan distance for fields up to 4x4
+ */
+struct PackedManhattanHeuristic: std::unary_function<const Field&, Cost> {
+    Cost operator ()(const Field& f) const {
+        return manhattan(pack(f), f.size);
+    }
+};
+
+struct PackedDisplacementHeuristic: std::unary_function<const Field&, Cost> {
+    Cost operator ()(const Field& f) const {
+        return misplaced(pack(f), f.size);
+    }
+};
+
+#endif // MANHATTAN_H
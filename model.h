@@ -86,6 +86,20 @@ std::ostream& operator << (std::ostream& os, const Position& pos) {
 
 typedef Position Displacement;
 
+/**
+ * @brief Directions the vacant place can be moved to, inverse(d) == d^1
+ */
+enum Direction {
+    Up = 0,
+    Down = 1,
+    Left = 2,
+    Right = 3
+};
+
+inline Direction inverse(Direction d) {
+    return static_cast<Direction>(d ^ 1);
+}
+
 struct Place
 {
     const Position position;
@@ -211,6 +225,24 @@ public:
         assert(static_cast<double>(size) == sqrt(tiles.size()));
     }
 
+    Field(const Field& other) = default;
+    Field(Field&& other) = default;
+    Field& operator = (Field&& other) = default;
+
+    /**
+     * @brief Place has const members and cannot be assigned element-wise,
+     *        so places are copy constructed anew
+     */
+    Field& operator = (const Field& other) {
+        size = other.size;
+        size_squared = other.size_squared;
+        places.clear();
+        places.insert(places.end(), other.places.begin(), other.places.end());
+        movementsDone = other.movementsDone;
+
+        return *this;
+    }
+
     std::ostream& print(std::ostream& os) const {
         os<<"\t";
         for(unsigned i=0;i<size_squared;i++){
@@ -235,6 +267,12 @@ public:
         return places[index(pos)].tileMaybe;
     }
 
+    const boost::optional<Tile>& at(const Position& pos) const {
+        assert(comprise(pos));
+
+        return places[index(pos)].tileMaybe;
+    }
+
     bool comprise(const Position& pos) const{
 
         return pos.row < size && pos.column < size && index(pos) < size_squared;
@@ -294,11 +332,16 @@ std::ostream& operator<<(std::ostream& os, const Field& f) {
 }
 
 
+/**
+ * @brief FNV-1a over tiles in place order. A plain sum of tiles is the same
+ *        for every field of a given size.
+ */
 struct CalculateHash{
     size_t* hash;
 
     void operator()(const Place& p){
-        (*hash)+=p.tileMaybe.get_value_or(Tile(0)).value;
+        (*hash)^=p.tileMaybe.get_value_or(Tile(0)).value;
+        (*hash)*=1099511628211ULL;
     }
 };
 
@@ -307,7 +350,7 @@ namespace std {
         struct hash< Field > {
             std::size_t operator()(const Field & c ) const
             {
-                size_t hash = 0;
+                size_t hash = 14695981039346656037ULL;
                 CalculateHash calculateHash;
                 calculateHash.hash = &hash;
 
@@ -317,6 +360,10 @@ namespace std {
                             calculateHash
                             );
 
+                hash ^= hash >> 32;
+                hash *= 0xd6e8feb86659fd93ULL;
+                hash ^= hash >> 32;
+
                 return hash;
             }
         };
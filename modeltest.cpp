@@ -82,6 +82,15 @@ TEST(FifteenTile, shouldConstructAsNeeded) {
     EXPECT_EQ(f.size, 3);
 }
 
+TEST(FifteenTile, shouldHashDifferentFieldsDifferently) {
+    Field f(3);
+    MoveLeft left22(Position(2,2));
+
+    EXPECT_EQ(std::hash<Field>()(f), std::hash<Field>()(Field(3)));
+    EXPECT_NE(std::hash<Field>()(f), std::hash<Field>()(left22(f)));
+    EXPECT_NE(std::hash<Field>()(f), std::hash<Field>()(testField()));
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,315 @@
+#ifndef MOVEPRUNING_H
+#define MOVEPRUNING_H
+
+#include "model.h"
+#include "astar.h"
+#include <stdint.h>
+#include <vector>
+#include <set>
+#include <map>
+#include <queue>
+#include <string>
+#include <utility>
+#include <algorithm>
+
+/**
+ * @brief Finite-state automaton over moves of the vacant place that rejects
+ *        move sequences having a cheaper (or equally cheap, lexicographically
+ *        smaller) equivalent.
+ *
+ * Duplicates are learned once by enumerating every sequence up to `maxLength`
+ * on an unbounded board: a sequence is forbidden if an already kept one gives
+ * the same permutation of tiles and moves the vacant place only through
+ * places the sequence itself visits, so the kept one is applicable wherever
+ * the forbidden one is. Forbidden sequences are then compiled into an
+ * Aho-Corasick automaton, a search only carries its small state id per node.
+ */
+class MoveAutomaton {
+public:
+    enum {
+        Start = 0,
+        Pruned = -1
+    };
+
+private:
+    typedef std::vector<uint8_t> Moves;
+    typedef std::pair<int, int> Cell;
+
+    struct Kept {
+        size_t length;
+        std::set<Cell> trajectory;
+    };
+
+    std::vector<int> transitions;
+    std::vector<Moves> forbidden;
+
+    static Cell step(const Cell& c, uint8_t d) {
+        switch(d) {
+        case Up:
+            return Cell(c.first-1, c.second);
+        case Down:
+            return Cell(c.first+1, c.second);
+        case Left:
+            return Cell(c.first, c.second-1);
+        default:
+            return Cell(c.first, c.second+1);
+        }
+    }
+
+    /**
+     * @brief Effect of the sequence as a comparable string: the original
+     *        place of the tile every displaced place holds, the vacant place
+     *        being the tile originally at (0, 0)
+     */
+    static std::string effect(const Moves& moves, std::set<Cell>& trajectory) {
+        std::map<Cell, Cell> tiles;
+        Cell blank(0, 0);
+        trajectory.clear();
+        trajectory.insert(blank);
+
+        for(size_t i = 0; i < moves.size(); i++) {
+            Cell to = step(blank, moves[i]);
+
+            std::map<Cell, Cell>::const_iterator moved = tiles.find(to);
+            tiles[blank] = moved == tiles.end() ? to : moved->second;
+            tiles[to] = Cell(0, 0);
+
+            blank = to;
+            trajectory.insert(blank);
+        }
+
+        std::string key;
+        for(std::map<Cell, Cell>::const_iterator it = tiles.begin(); it != tiles.end(); ++it) {
+            if(it->first != it->second) {
+                key += static_cast<char>(it->first.first);
+                key += static_cast<char>(it->first.second);
+                key += static_cast<char>(it->second.first);
+                key += static_cast<char>(it->second.second);
+            }
+        }
+
+        return key;
+    }
+
+    bool hasForbiddenSuffix(const Moves& moves, const std::set<Moves>& known) const {
+        for(size_t start = 0; start+1 < moves.size(); start++) {
+            if(known.count(Moves(moves.begin()+start, moves.end())) > 0) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void learn(unsigned maxLength) {
+        std::set<Moves> known;
+        std::map<std::string, std::vector<Kept> > kept;
+
+        std::set<Cell> trajectory;
+
+        Kept empty;
+        empty.length = 0;
+        kept[effect(Moves(), empty.trajectory)].push_back(empty);
+
+        std::vector<Moves> level(1);
+
+        for(unsigned length = 1; length <= maxLength; length++) {
+            std::vector<Moves> next;
+
+            for(size_t i = 0; i < level.size(); i++) {
+                for(uint8_t d = Up; d <= Right; d++) {
+                    Moves moves(level[i]);
+                    moves.push_back(d);
+
+                    if(hasForbiddenSuffix(moves, known)) {
+                        continue;
+                    }
+
+                    std::vector<Kept>& same = kept[effect(moves, trajectory)];
+
+                    bool duplicate = false;
+                    for(size_t k = 0; k < same.size() && !duplicate; k++) {
+                        duplicate = std::includes(
+                                    trajectory.begin(), trajectory.end(),
+                                    same[k].trajectory.begin(), same[k].trajectory.end());
+                    }
+
+                    if(duplicate) {
+                        known.insert(moves);
+                        forbidden.push_back(moves);
+                    } else {
+                        Kept k;
+                        k.length = length;
+                        k.trajectory = trajectory;
+                        same.push_back(k);
+                        next.push_back(moves);
+                    }
+                }
+            }
+
+            level.swap(next);
+        }
+    }
+
+    void compile() {
+        std::vector<int> trie(4, -1);
+        std::vector<bool> dead(1, false);
+
+        for(size_t i = 0; i < forbidden.size(); i++) {
+            int node = 0;
+            for(size_t j = 0; j < forbidden[i].size(); j++) {
+                int& child = trie[node*4+forbidden[i][j]];
+                if(child < 0) {
+                    child = dead.size();
+                    dead.push_back(false);
+                    trie.resize(trie.size()+4, -1);
+                }
+                node = trie[node*4+forbidden[i][j]];
+            }
+            dead[node] = true;
+        }
+
+        std::vector<int> fail(dead.size(), 0);
+        std::vector<int> delta(trie);
+        std::queue<int> frontier;
+
+        for(int d = Up; d <= Right; d++) {
+            if(delta[d] < 0) {
+                delta[d] = 0;
+            } else {
+                frontier.push(delta[d]);
+            }
+        }
+
+        while(!frontier.empty()) {
+            int node = frontier.front();
+            frontier.pop();
+            dead[node] = dead[node] || dead[fail[node]];
+
+            for(int d = Up; d <= Right; d++) {
+                int child = trie[node*4+d];
+                if(child < 0) {
+                    delta[node*4+d] = delta[fail[node]*4+d];
+                } else {
+                    fail[child] = delta[fail[node]*4+d];
+                    delta[node*4+d] = child;
+                    frontier.push(child);
+                }
+            }
+        }
+
+        std::vector<int> live(dead.size(), Pruned);
+        int count = 0;
+        for(size_t node = 0; node < dead.size(); node++) {
+            if(!dead[node]) {
+                live[node] = count++;
+            }
+        }
+
+        transitions.assign(count*4, Pruned);
+        for(size_t node = 0; node < dead.size(); node++) {
+            if(!dead[node]) {
+                for(int d = Up; d <= Right; d++) {
+                    transitions[live[node]*4+d] = live[delta[node*4+d]];
+                }
+            }
+        }
+    }
+
+public:
+
+    /**
+     * @brief Length 2 already gives parent-inverse pruning
+     */
+    explicit MoveAutomaton(unsigned maxLength = 10):
+        transitions(),
+        forbidden()
+    {
+        learn(maxLength);
+        compile();
+    }
+
+    /**
+     * @brief State after moving to `d` from `state`, or Pruned
+     */
+    int next(unsigned state, Direction d) const {
+        return transitions[state*4+d];
+    }
+
+    size_t states() const {
+        return transitions.size()/4;
+    }
+
+    size_t forbiddenSequences() const {
+        return forbidden.size();
+    }
+
+    bool accepts(const std::vector<Direction>& moves) const {
+        int state = Start;
+        for(size_t i = 0; i < moves.size() && state != Pruned; i++) {
+            state = next(state, moves[i]);
+        }
+
+        return state != Pruned;
+    }
+};
+
+/**
+ * @brief Move pruning policy walking a MoveAutomaton, actions have to
+ *        report their direction()
+ */
+template<typename ActionPtr>
+struct AutomatonMovePruning {
+    const MoveAutomaton* automaton;
+
+    AutomatonMovePruning(const MoveAutomaton* _automaton):
+        automaton(_automaton)
+    {}
+
+    unsigned start() const {
+        return MoveAutomaton::Start;
+    }
+
+    bool next(unsigned state, const ActionPtr& a, unsigned& following) const {
+        int n = automaton->next(state, a->direction());
+        if(n == MoveAutomaton::Pruned) {
+            return false;
+        }
+
+        following = n;
+        return true;
+    }
+};
+
+/**
+ * @brief Tree search skipping move sequences `automaton` knows a cheaper
+ *        equivalent of, actions have to report their direction()
+ */
+template <typename Domain, typename ActionPtr, typename ActionsIterator, typename CostFunction>
+bool pruned_tree_plan(
+        const Domain& initial,
+        const Domain& final,
+        const CostFunction heuristic,
+        const ActionsIterator actionsBegin,
+        const ActionsIterator actionsEnd,
+        const MoveAutomaton& automaton,
+        TracedDomain<Domain, ActionPtr>& history
+        ) {
+
+    GenericAStar<
+            Domain,
+            ActionPtr,
+            TreeVisitor<Domain>,
+            ActionsIterator,
+            FinalStateGoal<Domain>,
+            CostFunction,
+            PathCost<Domain, ActionPtr>,
+            AutomatonMovePruning<ActionPtr>
+            >
+            planner(initial, final, actionsBegin, actionsEnd, heuristic,
+                    PathCost<Domain, ActionPtr>(), TreeVisitor<Domain>(), AutomatonMovePruning<ActionPtr>(&automaton));
+
+    return planner.plan(history);
+}
+
+#endif // MOVEPRUNING_H
@@ -0,0 +1,107 @@
+#ifndef PACKED_H
+#define PACKED_H
+
+#include "model.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * @brief Board of at most 4x4 packed into 64 bits: nibble i holds the tile
+ *        standing at cell i (row-major), 0 stands for the vacant place.
+ */
+typedef uint64_t PackedField;
+
+enum { MaxPackedSize = 4 };
+
+inline unsigned tileAt(PackedField p, unsigned cell) {
+    return (p >> (4*cell)) & 0xF;
+}
+
+inline PackedField withTile(PackedField p, unsigned cell, unsigned tile) {
+    return (p & ~(PackedField(0xF) << (4*cell))) | (PackedField(tile) << (4*cell));
+}
+
+inline PackedField pack(const Field& f) {
+    assert(f.size <= MaxPackedSize);
+
+    PackedField p = 0;
+    unsigned cell = 0;
+    for(Field::const_iterator it = f.begin(); it != f.end(); ++it, ++cell) {
+        p = withTile(p, cell, it->tileMaybe.get_value_or(Tile(0)).value);
+    }
+
+    return p;
+}
+
+inline Field unpack(PackedField p, unsigned size) {
+    assert(size <= MaxPackedSize);
+
+    std::vector<Place> places;
+    for(unsigned cell = 0; cell < size*size; cell++) {
+        Position pos(cell/size, cell%size);
+        unsigned tile = tileAt(p, cell);
+
+        if(tile == 0) {
+            places.push_back(Place(pos));
+        } else {
+            places.push_back(Place(pos, Tile(tile)));
+        }
+    }
+
+    return Field(places);
+}
+
+/**
+ * @brief Packed counterpart of Field(size)
+ */
+inline PackedField packedGoal(unsigned size) {
+    PackedField p = 0;
+    for(unsigned cell = 0; cell+1 < size*size; cell++) {
+        p = withTile(p, cell, cell+1);
+    }
+
+    return p;
+}
+
+inline unsigned blankAt(PackedField p, unsigned size) {
+    for(unsigned cell = 0; cell < size*size; cell++) {
+        if(tileAt(p, cell) == 0) {
+            return cell;
+        }
+    }
+
+    assert(false);
+    return size*size;
+}
+
+/**
+ * @brief Cell the vacant place ends up at after moving it from `blank` to `d`,
+ *        or size*size when the move leaves the board
+ */
+inline unsigned neighbour(unsigned blank, Direction d, unsigned size) {
+    unsigned row = blank/size;
+    unsigned col = blank%size;
+
+    switch(d) {
+    case Up:
+        return row > 0 ? blank-size : size*size;
+    case Down:
+        return row+1 < size ? blank+size : size*size;
+    case Left:
+        return col > 0 ? blank-1 : size*size;
+    case Right:
+        return col+1 < size ? blank+1 : size*size;
+    }
+
+    return size*size;
+}
+
+/**
+ * @brief Slides the tile at `to` into the vacant place at `blank`
+ */
+inline PackedField slide(PackedField p, unsigned blank, unsigned to) {
+    assert(tileAt(p, blank) == 0);
+    return withTile(withTile(p, blank, tileAt(p, to)), to, 0);
+}
+
+#endif // PACKED_H
@@ -0,0 +1,654 @@
+#ifndef PACKEDASTAR_H
+#define PACKEDASTAR_H
+
+#include "astar.h"
+#include "packed.h"
+#include "manhattan.h"
+#include "closedset.h"
+#include "timeline.h"
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+#include <boost/utility.hpp>
+
+inline size_t hashPacked(PackedField p) {
+    return ClosedSetKey<uint64_t>::hash(p);
+}
+
+/**
+ * @brief Map from packed field to node id
+ */
+typedef ClosedSet<PackedField, uint32_t> PackedStateTable;
+
+/**
+ * @brief Source of exact distances to Field(size) for some of the fields,
+ *        with the move to take from there
+ */
+struct ExactDistances {
+    virtual bool lookup(PackedField p, unsigned& distance, Direction& next) const = 0;
+    virtual ~ExactDistances() {}
+};
+
+/**
+ * @brief Batch heuristic used by PackedAStar: evaluates `count` fields at once
+ */
+struct PackedManhattan {
+    void operator()(const PackedField* fields, Cost* costs, size_t count, unsigned size) const {
+        manhattan(fields, costs, count, size);
+    }
+};
+
+/**
+ * @brief How a batch heuristic changes when the tile at `from` slides to the
+ *        vacant place `to`, for heuristics it can be told from tables ahead of
+ *        evaluating the child (Known)
+ */
+template<typename BatchHeuristic>
+struct OperatorTable {
+    enum { Known = false };
+
+    explicit OperatorTable(unsigned size)
+    {}
+
+    Cost delta(PackedField p, unsigned from, unsigned to) const {
+        return 0;
+    }
+};
+
+template<>
+struct OperatorTable<PackedManhattan> {
+    enum { Known = true };
+
+    int8_t distance[16][16];
+
+    explicit OperatorTable(unsigned size)
+    {
+        const ManhattanTables& t = manhattanTables(size);
+
+        for(unsigned tile = 0; tile < 16; tile++) {
+            for(unsigned cell = 0; cell < 16; cell++) {
+                distance[tile][cell] = tile == 0 ? 0 :
+                        abs(int(t.cellRow[cell]) - t.goalRow[tile]) + abs(int(t.cellCol[cell]) - t.goalCol[tile]);
+            }
+        }
+    }
+
+    Cost delta(PackedField p, unsigned from, unsigned to) const {
+        unsigned tile = tileAt(p, from);
+        return distance[tile][to] - distance[tile][from];
+    }
+};
+
+/**
+ * @brief Cost of sliding from a field to its neighbour; PackedAStar and
+ *        PackedDStarLite take any integer costs of at least 1 (their
+ *        heuristics count moves)
+ */
+struct UnitMoveCost {
+    Cost operator()(PackedField from, PackedField to) const {
+        return 1;
+    }
+};
+
+/**
+ * @brief Sliding costs as much as the number of the tile moved, which is the
+ *        nibble the two fields differ in
+ */
+struct TileNumberCost {
+    Cost operator()(PackedField from, PackedField to) const {
+        PackedField changed = from ^ to;
+        return (changed >> (__builtin_ctzll(changed) & ~3u)) & 0xF;
+    }
+};
+
+/**
+ * @brief A* over packed fields (up to 4x4) towards Field(size).
+ *
+ * Nodes are expanded in batches of equal f: all successors of a batch are
+ * generated into reusable structure-of-arrays buffers, then evaluated, hashed
+ * (prefetching the table slots) and probed against the table in separate tight
+ * loops. Open list is a bucket per f value, LIFO inside a bucket.
+ *
+ * Given ExactDistances, a generated field they know turns into a complete
+ * candidate solution; the search stops as soon as no open node can beat the
+ * best candidate.
+ *
+ * With partial expansion (EPEA*) a node popped at some F only adds children
+ * of that f and goes back to the open list at the next f of its children.
+ * When the heuristic has an OperatorTable, children of other f are not even
+ * generated, otherwise they are generated, evaluated and dropped.
+ *
+ * Moves cost what MoveCost says; g is kept in the node and updated by that
+ * on generation, and buckets are added as far as f goes.
+ */
+template<typename BatchHeuristic = PackedManhattan, typename MoveCost = UnitMoveCost>
+class PackedAStar: public boost::noncopyable
+{
+    struct Node {
+        PackedField state;
+        uint32_t parent;
+        Cost g;
+        Cost h;
+        uint8_t blank;
+        uint8_t move;
+    };
+
+    static const uint32_t NoParent = 0xFFFFFFFF;
+    static const uint8_t NoMove = 4;
+
+    const unsigned size;
+    const size_t batchSize;
+    const PackedField goal;
+    BatchHeuristic heuristic;
+    MoveCost moveCost;
+    const OperatorTable<BatchHeuristic> operators;
+    bool partial;
+
+    std::vector<Node> nodes;
+    PackedStateTable table;
+
+    std::vector< std::vector<uint32_t> > open;
+    size_t openMinF;
+    size_t openSize;
+
+    std::vector<uint32_t> batch;
+    size_t batchF;
+    std::vector<size_t> batchNextF;
+
+    std::vector<PackedField> childState;
+    std::vector<uint32_t> childParent;
+    std::vector<Cost> childG;
+    std::vector<Cost> childH;
+    std::vector<size_t> childHash;
+    std::vector<uint8_t> childBlank;
+    std::vector<uint8_t> childMove;
+    std::vector<uint32_t> childOrigin;
+
+    size_t expandedCount;
+    size_t generatedCount;
+    size_t peakOpenSize;
+    Cost planCost;
+
+    const ExactDistances* exact;
+    SearchTimeline* timeline;
+    size_t bound;
+    uint32_t boundNode;
+    std::vector<Direction> boundTail;
+
+    void push(uint32_t id, size_t f) {
+        if(open.size() <= f) {
+            open.resize(f+1);
+        }
+        open[f].push_back(id);
+        openMinF = std::min(openMinF, f);
+        openSize++;
+        peakOpenSize = std::max(peakOpenSize, openSize);
+    }
+
+    /**
+     * @brief Pops up to batchSize nodes of the minimal f, skipping those a
+     *        cheaper path was found to since they had been pushed
+     */
+    bool popBatch() {
+        batch.clear();
+
+        while(openMinF < open.size() && open[openMinF].empty()) {
+            openMinF++;
+        }
+        if(openMinF >= open.size() || openMinF >= bound) {
+            return false;
+        }
+
+        batchF = openMinF;
+
+        std::vector<uint32_t>& bucket = open[openMinF];
+        while(!bucket.empty() && batch.size() < batchSize) {
+            uint32_t id = bucket.back();
+            bucket.pop_back();
+            openSize--;
+
+            if(table.find(nodes[id].state, hashPacked(nodes[id].state)) == id) {
+                batch.push_back(id);
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Whether a child of f `childF` is added when its parent is
+     *        expanded at F `batchF`: the first expansion, at the parent's own
+     *        f, also takes children below it (heuristic may be inconsistent)
+     */
+    bool emits(const Node& parent, size_t childF) const {
+        return childF == batchF || (childF < batchF && batchF == size_t(parent.g + parent.h));
+    }
+
+    void generate() {
+        // exact distances replace h, so it can no longer be updated by deltas
+        const bool known = partial && OperatorTable<BatchHeuristic>::Known && exact == 0;
+
+        childState.clear();
+        childParent.clear();
+        childG.clear();
+        childH.clear();
+        childBlank.clear();
+        childMove.clear();
+        childOrigin.clear();
+        batchNextF.assign(batch.size(), SIZE_MAX);
+
+        for(size_t i = 0; i < batch.size(); i++) {
+            const Node& n = nodes[batch[i]];
+
+            for(unsigned d = Up; d <= Right; d++) {
+                if(n.move != NoMove && d == inverse(static_cast<Direction>(n.move))) {
+                    continue;
+                }
+
+                unsigned to = neighbour(n.blank, static_cast<Direction>(d), size);
+                if(to >= size*size) {
+                    continue;
+                }
+
+                PackedField child = slide(n.state, n.blank, to);
+                Cost g = n.g + moveCost(n.state, child);
+
+                if(known) {
+                    Cost h = n.h + operators.delta(n.state, to, n.blank);
+                    size_t f = g + h;
+
+                    if(!emits(n, f)) {
+                        if(f > batchF) {
+                            batchNextF[i] = std::min(batchNextF[i], f);
+                        }
+                        continue;
+                    }
+                    childH.push_back(h);
+                }
+
+                childState.push_back(child);
+                childParent.push_back(batch[i]);
+                childG.push_back(g);
+                childBlank.push_back(to);
+                childMove.push_back(d);
+                childOrigin.push_back(i);
+            }
+        }
+
+        expandedCount += batch.size();
+        generatedCount += childState.size();
+    }
+
+    void evaluate() {
+        const size_t count = childState.size();
+
+        childHash.resize(count);
+
+        if(count == 0) {
+            return;
+        }
+
+        if(childH.size() != count) {
+            childH.resize(count);
+            heuristic(&childState[0], &childH[0], count, size);
+        }
+
+        for(size_t i = 0; i < count; i++) {
+            childHash[i] = hashPacked(childState[i]);
+            table.prefetch(childHash[i]);
+        }
+    }
+
+    void insert() {
+        for(size_t i = 0; i < childState.size(); i++) {
+            if(partial) {
+                const Node& parent = nodes[childParent[i]];
+                size_t f = childG[i] + childH[i];
+
+                if(!emits(parent, f)) {
+                    if(f > batchF) {
+                        batchNextF[childOrigin[i]] = std::min(batchNextF[childOrigin[i]], f);
+                    }
+                    continue;
+                }
+            }
+
+            uint32_t known = table.find(childState[i], childHash[i]);
+            if(known != PackedStateTable::NotFound && nodes[known].g <= childG[i]) {
+                continue;
+            }
+
+            Node n;
+            n.state = childState[i];
+            n.parent = childParent[i];
+            n.g = childG[i];
+            n.blank = childBlank[i];
+            n.move = childMove[i];
+
+            uint32_t id = nodes.size();
+            nodes.push_back(n);
+            table.insert(n.state, childHash[i], id);
+
+            Cost h = childH[i];
+            consult(id, h);
+            nodes[id].h = h;
+            push(id, childG[i]+h);
+        }
+
+        for(size_t i = 0; partial && i < batch.size(); i++) {
+            if(batchNextF[i] != SIZE_MAX) {
+                push(batch[i], batchNextF[i]);
+            }
+        }
+    }
+
+    /**
+     * @brief Replaces h with the exact distance if known, and keeps the node
+     *        as the best candidate if it completes the cheapest solution so far
+     */
+    void consult(uint32_t id, Cost& h) {
+        unsigned distance;
+        Direction next;
+
+        if(exact == 0 || !exact->lookup(nodes[id].state, distance, next)) {
+            return;
+        }
+
+        h = distance;
+        if(nodes[id].g + distance >= bound) {
+            return;
+        }
+
+        std::vector<Direction> tail;
+        if(!walk(nodes[id].state, tail)) {
+            return;
+        }
+
+        bound = nodes[id].g + distance;
+        boundNode = id;
+        boundTail.swap(tail);
+    }
+
+    /**
+     * @brief Follows exact distances to the goal, fails if some field on the
+     *        way is not known (any more)
+     */
+    bool walk(PackedField p, std::vector<Direction>& tail) const {
+        unsigned distance;
+        Direction next;
+
+        unsigned expected = 0;
+
+        tail.clear();
+        while(p != goal) {
+            if(!exact->lookup(p, distance, next) || (!tail.empty() && distance != expected)) {
+                return false;
+            }
+            expected = distance-1;
+
+            unsigned blank = blankAt(p, size);
+            unsigned to = neighbour(blank, next, size);
+            if(to >= size*size) {
+                return false;
+            }
+
+            p = slide(p, blank, to);
+            tail.push_back(next);
+        }
+
+        return true;
+    }
+
+    void path(uint32_t id, std::vector<Direction>& moves) const {
+        moves.clear();
+        for(; nodes[id].parent != NoParent; id = nodes[id].parent) {
+            moves.push_back(static_cast<Direction>(nodes[id].move));
+        }
+        std::reverse(moves.begin(), moves.end());
+    }
+
+    void reset(PackedField initial) {
+        nodes.clear();
+        table.clear();
+        open.clear();
+        openMinF = 0;
+        openSize = 0;
+        expandedCount = 0;
+        generatedCount = 0;
+        peakOpenSize = 0;
+        bound = SIZE_MAX;
+        boundNode = NoParent;
+        boundTail.clear();
+
+        Node n;
+        n.state = initial;
+        n.parent = NoParent;
+        n.g = 0;
+        n.blank = blankAt(initial, size);
+        n.move = NoMove;
+
+        nodes.push_back(n);
+        table.insert(initial, hashPacked(initial), 0);
+
+        Cost h;
+        heuristic(&initial, &h, 1, size);
+        consult(0, h);
+        nodes[0].h = h;
+        push(0, h);
+    }
+
+public:
+
+    PackedAStar(unsigned _size, size_t _batchSize = 64, const BatchHeuristic& _heuristic = BatchHeuristic(),
+                const MoveCost& _moveCost = MoveCost()):
+        size(_size),
+        batchSize(_batchSize),
+        goal(packedGoal(_size)),
+        heuristic(_heuristic),
+        moveCost(_moveCost),
+        operators(_size),
+        partial(false),
+        openMinF(0),
+        openSize(0),
+        batchF(0),
+        expandedCount(0),
+        generatedCount(0),
+        peakOpenSize(0),
+        planCost(0),
+        exact(0),
+        timeline(0),
+        bound(SIZE_MAX),
+        boundNode(NoParent)
+    {
+        assert(size <= MaxPackedSize);
+        assert(batchSize > 0);
+    }
+
+    /**
+     * @brief Fills `moves` with directions the vacant place is to be moved to
+     *        on the way from `initial` to Field(size)
+     */
+    bool plan(PackedField initial, std::vector<Direction>& moves) {
+        reset(initial);
+
+        while(popBatch()) {
+            if(timeline != 0 && timeline->due()) {
+                timeline->sample(openSize, nodes.size(), batchF, expandedCount);
+            }
+
+            for(size_t i = 0; i < batch.size(); i++) {
+                if(nodes[batch[i]].state == goal) {
+                    path(batch[i], moves);
+                    planCost = nodes[batch[i]].g;
+                    return true;
+                }
+            }
+
+            generate();
+            evaluate();
+            insert();
+        }
+
+        if(boundNode != NoParent) {
+            path(boundNode, moves);
+            planCost = bound;
+            moves.insert(moves.end(), boundTail.begin(), boundTail.end());
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Switches partial expansion (EPEA*) on or off for the following
+     *        searches
+     */
+    void usePartialExpansion(bool enabled) {
+        partial = enabled;
+    }
+
+    /**
+     * @brief Consults `distances` (may be 0) during the following searches;
+     *        they count moves, so they only fit unit move costs
+     */
+    void useExactDistances(const ExactDistances* distances) {
+        exact = distances;
+    }
+
+    /**
+     * @brief Samples every following search into `samples` (may be 0), one
+     *        after another; each counts its expansions from 0
+     */
+    void useTimeline(SearchTimeline* samples) {
+        timeline = samples;
+    }
+
+    size_t expanded() const {
+        return expandedCount;
+    }
+
+    /**
+     * @brief Cost of the solution found by the last plan
+     */
+    Cost cost() const {
+        return planCost;
+    }
+
+    size_t generated() const {
+        return generatedCount;
+    }
+
+    size_t peakOpen() const {
+        return peakOpenSize;
+    }
+};
+
+/**
+ * @brief GenericAStar visitor keeping the best g of every reached field
+ *        packed in a ClosedSet instead of whole fields in `closed_set`, and
+ *        dropping fields reached before at no greater cost
+ */
+template<typename Domain>
+struct PackedClosedVisitor {
+    ClosedSet<PackedField, Cost>* closed;
+
+    PackedClosedVisitor(ClosedSet<PackedField, Cost>* _closed):
+        closed(_closed)
+    {}
+
+    void operator()(const Domain& d, std::unordered_set<Domain>& closed_set) {
+    }
+
+    bool visited(const Domain& d, Cost g, const std::unordered_set<Domain>& closed_set) {
+        return !closed->improve(pack(d), g);
+    }
+};
+
+/**
+ * @brief Graph search over fields up to 4x4 with the closed set in `closed`
+ */
+template <typename ActionPtr, typename ActionsIterator, typename CostFunction>
+bool graph_plan(
+        const Field& initial,
+        const Field& final,
+        const CostFunction heuristic,
+        const ActionsIterator actionsBegin,
+        const ActionsIterator actionsEnd,
+        ClosedSet<PackedField, Cost>& closed,
+        TracedDomain<Field, ActionPtr>& history
+        ) {
+
+    closed.clear();
+
+    GenericAStar<
+            Field,
+            ActionPtr,
+            PackedClosedVisitor<Field>,
+            ActionsIterator,
+            FinalStateGoal<Field>,
+            CostFunction
+            >
+            planner(initial, final, actionsBegin, actionsEnd, heuristic,
+                    PathCost<Field, ActionPtr>(), PackedClosedVisitor<Field>(&closed));
+
+    return planner.plan(history);
+}
+
+/**
+ * @brief Applies `moves` of the vacant place to `history`, picking for each of
+ *        them the action of [begin, end) that leads to the same field
+ */
+template <typename ActionPtr, typename ActionsIterator>
+void replay(
+        const std::vector<Direction>& moves,
+        const ActionsIterator actionsBegin,
+        const ActionsIterator actionsEnd,
+        TracedDomain<Field, ActionPtr>& history
+        ) {
+
+    const unsigned size = history.domain().size;
+    PackedField current = pack(history.domain());
+
+    for(size_t i = 0; i < moves.size(); i++) {
+        unsigned blank = blankAt(current, size);
+        unsigned to = neighbour(blank, moves[i], size);
+        assert(to < size*size);
+
+        PackedField next = slide(current, blank, to);
+        Field expected = unpack(next, size);
+
+        ActionsIterator a = actionsBegin;
+        for(; a != actionsEnd; ++a) {
+            if((*a)->isDefined(history.domain()) && (**a)(history.domain()) == expected) {
+                break;
+            }
+        }
+        assert(a != actionsEnd);
+
+        history.accept(*a);
+        current = next;
+    }
+}
+
+template <typename ActionPtr, typename ActionsIterator>
+bool packed_plan(
+        const Field& initial,
+        const ActionsIterator actionsBegin,
+        const ActionsIterator actionsEnd,
+        TracedDomain<Field, ActionPtr>& history
+        ) {
+
+    PackedAStar<> planner(initial.size);
+    std::vector<Direction> moves;
+
+    if(!planner.plan(pack(initial), moves)) {
+        return false;
+    }
+
+    history = TracedDomain<Field, ActionPtr>(initial);
+    replay(moves, actionsBegin, actionsEnd, history);
+
+    return true;
+}
+
+#endif // PACKEDASTAR_H
@@ -0,0 +1,742 @@
+#include "astar.h"
+#include "model.h"
+#include "actions.h"
+#include "packed.h"
+#include "manhattan.h"
+#include "packedastar.h"
+#include "heuristictables.h"
+#include "eightoracle.h"
+#include "solutioncache.h"
+#include "incremental.h"
+#include "idastar.h"
+#include "distributed.h"
+#include "perimeter.h"
+#include "testfields.h"
+#include <set>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <gtest/gtest.h>
+#include <stdlib.h>
+
+PackedField applyMoves(PackedField p, unsigned size, const std::vector<Direction>& moves) {
+    for(size_t i = 0; i < moves.size(); i++) {
+        unsigned blank = blankAt(p, size);
+        unsigned to = neighbour(blank, moves[i], size);
+        assert(to < size*size);
+        p = slide(p, blank, to);
+    }
+
+    return p;
+}
+
+/**
+ * @brief  8|1|7
+ *         4|5|6
+ *         2|_|3
+ */
+TEST(PackedAStar, shouldFindTheSameSolutionLengthAsGraphPlan) {
+    std::vector<FifteenAction*> actions;
+
+    Field f = testField();
+    TracedDomain<Field, FifteenAction*> solution(f);
+    TracedDomain<Field, FifteenAction*> packedSolution(f);
+
+    allPossibleActions(f, actions);
+
+    graph_plan(f, Field(3), PackedManhattanHeuristic(), actions.begin(), actions.end(), solution);
+    EXPECT_TRUE(packed_plan(f, actions.begin(), actions.end(), packedSolution));
+
+    EXPECT_TRUE(packedSolution.domain() == Field(3));
+    EXPECT_EQ(packedSolution.actions().size(), solution.actions().size());
+}
+
+TEST(PathCost, shouldBeKeptByTracedDomain) {
+    std::vector<FifteenAction*> actions;
+    std::vector<FifteenAction*> weighted;
+
+    srand(41);
+    Field f = unpack(randomWalk(3, 30), 3);
+    allPossibleActions(f, actions);
+    for(size_t a = 0; a < actions.size(); a++) {
+        weighted.push_back(new TileWeightedAction(actions[a]));
+    }
+
+    TracedDomain<Field, FifteenAction*> unit(f);
+    ASSERT_TRUE(graph_plan(f, Field(3), PackedManhattanHeuristic(), actions.begin(), actions.end(), unit));
+    EXPECT_EQ(unit.cost(), Cost(unit.actions().size()));
+
+    TracedDomain<Field, FifteenAction*> cheapest(f);
+    ASSERT_TRUE(graph_plan(f, Field(3), PackedManhattanHeuristic(), weighted.begin(), weighted.end(), cheapest));
+    EXPECT_TRUE(cheapest.domain() == Field(3));
+
+    Cost replayed = 0;
+    TracedDomain<Field, FifteenAction*> replay(f);
+    for(size_t a = 0; a < cheapest.actions().size(); a++) {
+        replayed += cheapest.actions()[a]->cost(replay.domain());
+        replay.accept(cheapest.actions()[a]);
+    }
+
+    Cost unitWeighted = 0;
+    TracedDomain<Field, FifteenAction*> unitReplay(f);
+    for(size_t a = 0; a < unit.actions().size(); a++) {
+        unitWeighted += TileWeightedAction(unit.actions()[a]).cost(unitReplay.domain());
+        unitReplay.accept(unit.actions()[a]);
+    }
+
+    EXPECT_LE(cheapest.cost(), unitWeighted);
+    EXPECT_EQ(cheapest.cost(), replayed);
+
+    PackedAStar<PackedManhattan, TileNumberCost> packed(3);
+    std::vector<Direction> moves;
+    ASSERT_TRUE(packed.plan(pack(f), moves));
+    EXPECT_EQ(packed.cost(), cheapest.cost());
+    EXPECT_EQ(applyMoves(pack(f), 3, moves), packedGoal(3));
+}
+
+TEST(PackedAStar, shouldFindCheapestSolutionsWithTileNumberCosts) {
+    srand(41);
+
+    for(unsigned i = 0; i < 5; i++) {
+        PackedField initial = randomWalk(3, 60);
+
+        PackedAStar<PackedManhattan, TileNumberCost> weighted(3);
+        PackedDStarLite<TileNumberCost> reference(3);
+
+        std::vector<Direction> moves;
+        std::vector<Direction> expected;
+        ASSERT_TRUE(weighted.plan(initial, moves));
+        ASSERT_TRUE(reference.plan(initial, expected));
+
+        Cost expectedCost = 0;
+        PackedField p = initial;
+        for(size_t m = 0; m < expected.size(); m++) {
+            unsigned blank = blankAt(p, 3);
+            PackedField next = slide(p, blank, neighbour(blank, expected[m], 3));
+            expectedCost += TileNumberCost()(p, next);
+            p = next;
+        }
+
+        EXPECT_EQ(weighted.cost(), expectedCost);
+        EXPECT_EQ(applyMoves(initial, 3, moves), packedGoal(3));
+    }
+}
+
+TEST(PackedAStar, shouldSampleItsTimeline) {
+    srand(44);
+    PackedField initial = randomWalk(4, 200);
+
+    SearchTimeline timeline(0, 1);
+    PackedAStar<> sampled(4);
+    sampled.useTimeline(&timeline);
+
+    std::vector<Direction> moves;
+    ASSERT_TRUE(sampled.plan(initial, moves));
+
+    const std::vector<SearchTimeline::Sample>& samples = timeline.samples();
+    ASSERT_GT(samples.size(), 1u);
+    for(size_t i = 1; i < samples.size(); i++) {
+        EXPECT_GE(samples[i].f, samples[i-1].f);
+        EXPECT_GE(samples[i].expanded, samples[i-1].expanded);
+        EXPECT_GE(samples[i].closed, samples[i-1].closed);
+    }
+    EXPECT_LE(samples.back().f, Cost(moves.size()));
+    EXPECT_LE(samples.back().expanded, sampled.expanded());
+}
+
+TEST(PackedAStar, shouldSampleSeveralSearchesIntoOneTimeline) {
+    srand(44);
+
+    SearchTimeline timeline(0, 1);
+    PackedAStar<> sampled(4);
+    sampled.useTimeline(&timeline);
+
+    std::vector<Direction> moves;
+    ASSERT_TRUE(sampled.plan(randomWalk(4, 200), moves));
+    const size_t first = timeline.samples().size();
+    ASSERT_TRUE(sampled.plan(randomWalk(4, 200), moves));
+
+    const std::vector<SearchTimeline::Sample>& samples = timeline.samples();
+    ASSERT_GT(samples.size(), first);
+    EXPECT_LT(samples[first].expanded, samples[first-1].expanded);
+    EXPECT_EQ(timeline.rate(first), 0);
+
+    double fastest = 0;
+    for(size_t i = 0; i < samples.size(); i++) {
+        EXPECT_GE(timeline.rate(i), 0);
+        fastest = std::max(fastest, timeline.rate(i));
+    }
+    EXPECT_LT(fastest, 1e10);
+}
+
+TEST(PackedAStar, batchedExpansionShouldMatchOneByOne) {
+    srand(27);
+
+    PackedAStar<> batched(4, 256);
+    PackedAStar<> single(4, 1);
+
+    for(unsigned i = 0; i < 5; i++) {
+        PackedField initial = randomWalk(4, 80);
+
+        std::vector<Direction> batchedMoves;
+        std::vector<Direction> singleMoves;
+
+        ASSERT_TRUE(batched.plan(initial, batchedMoves));
+        ASSERT_TRUE(single.plan(initial, singleMoves));
+
+        EXPECT_EQ(batchedMoves.size(), singleMoves.size());
+        EXPECT_EQ(applyMoves(initial, 4, batchedMoves), packedGoal(4));
+        EXPECT_EQ(applyMoves(initial, 4, singleMoves), packedGoal(4));
+    }
+}
+
+TEST(PackedAStar, strongerTablesShouldKeepOptimalityAndExpandLess) {
+    srand(28);
+
+    PackedAStar<> manhattan(4);
+    PackedAStar<PackedLinearConflict> conflicts(4);
+    PackedAStar<PackedWalkingDistance> walking(4);
+
+    for(unsigned i = 0; i < 5; i++) {
+        PackedField initial = randomWalk(4, 80);
+
+        std::vector<Direction> manhattanMoves;
+        std::vector<Direction> conflictsMoves;
+        std::vector<Direction> walkingMoves;
+
+        ASSERT_TRUE(manhattan.plan(initial, manhattanMoves));
+        ASSERT_TRUE(conflicts.plan(initial, conflictsMoves));
+        ASSERT_TRUE(walking.plan(initial, walkingMoves));
+
+        EXPECT_EQ(conflictsMoves.size(), manhattanMoves.size());
+        EXPECT_EQ(walkingMoves.size(), manhattanMoves.size());
+        EXPECT_LE(conflicts.expanded(), manhattan.expanded());
+    }
+}
+
+TEST(PackedAStar, partialExpansionShouldKeepOptimalityAndShrinkOpenList) {
+    srand(36);
+
+    size_t fullOpen = 0;
+    size_t partialOpen = 0;
+
+    for(unsigned i = 0; i < 5; i++) {
+        PackedField initial = randomWalk(4, 200);
+
+        PackedAStar<> full(4);
+        PackedAStar<> partial(4);
+        PackedAStar<PackedLinearConflict> partialConflicts(4);
+        partial.usePartialExpansion(true);
+        partialConflicts.usePartialExpansion(true);
+
+        std::vector<Direction> fullMoves;
+        std::vector<Direction> partialMoves;
+        std::vector<Direction> conflictsMoves;
+
+        ASSERT_TRUE(full.plan(initial, fullMoves));
+        ASSERT_TRUE(partial.plan(initial, partialMoves));
+        ASSERT_TRUE(partialConflicts.plan(initial, conflictsMoves));
+
+        EXPECT_EQ(partialMoves.size(), fullMoves.size());
+        EXPECT_EQ(conflictsMoves.size(), fullMoves.size());
+        EXPECT_EQ(applyMoves(initial, 4, partialMoves), packedGoal(4));
+        EXPECT_EQ(applyMoves(initial, 4, conflictsMoves), packedGoal(4));
+        EXPECT_LT(2*partial.generated(), 3*full.generated());
+        EXPECT_LE(partial.peakOpen(), full.peakOpen());
+
+        fullOpen += full.peakOpen();
+        partialOpen += partial.peakOpen();
+    }
+
+    EXPECT_LT(partialOpen, fullOpen);
+}
+
+TEST(PackedIDAStar, shouldFindOptimalSolutionsInParallel) {
+    srand(38);
+
+    MoveAutomaton automaton(6);
+
+    for(unsigned i = 0; i < 5; i++) {
+        PackedField initial = randomWalk(4, 200);
+
+        PackedAStar<> reference(4);
+        std::vector<Direction> expected;
+        ASSERT_TRUE(reference.plan(initial, expected));
+
+        PackedIDAStar single(4, &automaton);
+        ParallelIDAStar parallel(4, 4, &automaton);
+        ParallelIDAStar unpruned(4, 3);
+
+        std::vector<Direction> singleMoves;
+        std::vector<Direction> parallelMoves;
+        std::vector<Direction> unprunedMoves;
+
+        ASSERT_TRUE(single.plan(initial, singleMoves));
+        ASSERT_TRUE(parallel.plan(initial, parallelMoves));
+        ASSERT_TRUE(unpruned.plan(initial, unprunedMoves));
+
+        EXPECT_EQ(singleMoves.size(), expected.size());
+        EXPECT_EQ(parallelMoves.size(), expected.size());
+        EXPECT_EQ(unprunedMoves.size(), expected.size());
+        EXPECT_EQ(applyMoves(initial, 4, singleMoves), packedGoal(4));
+        EXPECT_EQ(applyMoves(initial, 4, parallelMoves), packedGoal(4));
+        EXPECT_EQ(applyMoves(initial, 4, unprunedMoves), packedGoal(4));
+    }
+}
+
+TEST(PackedIDAStar, shouldSolveFieldsCloserThanTheWorkUnits) {
+    ParallelIDAStar parallel(3, 4);
+
+    std::vector<Direction> moves(1, Up);
+    ASSERT_TRUE(parallel.plan(packedGoal(3), moves));
+    EXPECT_TRUE(moves.empty());
+
+    std::vector<Direction> twoMoves;
+    twoMoves.push_back(Up);
+    twoMoves.push_back(Left);
+    PackedField initial = applyMoves(packedGoal(3), 3, twoMoves);
+
+    ASSERT_TRUE(parallel.plan(initial, moves));
+    EXPECT_EQ(moves.size(), 2u);
+    EXPECT_EQ(applyMoves(initial, 3, moves), packedGoal(3));
+}
+
+TEST(DistributedAStar, shouldFindOptimalSolutionsWithSeveralProcesses) {
+    srand(40);
+
+    for(unsigned i = 0; i < 3; i++) {
+        PackedField initial = randomWalk(4, 100);
+
+        PackedAStar<> reference(4);
+        std::vector<Direction> expected;
+        ASSERT_TRUE(reference.plan(initial, expected));
+
+        DistributedAStar distributed(4, 3);
+        std::vector<Direction> moves;
+        ASSERT_TRUE(distributed.plan(initial, moves));
+
+        EXPECT_EQ(moves.size(), expected.size());
+        EXPECT_EQ(applyMoves(initial, 4, moves), packedGoal(4));
+        EXPECT_GT(distributed.rounds(), 0u);
+    }
+
+    DistributedAStar distributed(3, 2);
+    std::vector<Direction> moves(1, Up);
+    ASSERT_TRUE(distributed.plan(packedGoal(3), moves));
+    EXPECT_TRUE(moves.empty());
+}
+
+TEST(DistributedAStar, shouldStoreMoreThanOneProcessBudget) {
+    srand(41);
+
+    PackedField initial = randomWalk(4, 200);
+
+    DistributedAStar unbounded(4, 1);
+    std::vector<Direction> expected;
+    ASSERT_TRUE(unbounded.plan(initial, expected));
+
+    const size_t budget = unbounded.stored()/2;
+
+    DistributedAStar single(4, 1, budget);
+    std::vector<Direction> moves;
+    EXPECT_FALSE(single.plan(initial, moves));
+    EXPECT_TRUE(single.outOfBudget());
+
+    DistributedAStar several(4, 4, budget);
+    ASSERT_TRUE(several.plan(initial, moves));
+    EXPECT_FALSE(several.outOfBudget());
+    EXPECT_EQ(moves.size(), expected.size());
+    EXPECT_GT(several.stored(), budget);
+    EXPECT_LE(several.peakStored(), budget);
+}
+
+TEST(DistributedAStar, writingToAGoneWorkerShouldFailWithoutSignal) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    close(fds[1]);
+
+    distributed::Record r;
+    EXPECT_FALSE(distributed::send(fds[0], distributed::Seed, 0, std::vector<distributed::Record>(1, r)));
+    close(fds[0]);
+}
+
+TEST(AStar, shouldFindTheSameSolutionWithTableHeuristics) {
+    std::vector<FifteenAction*> actions;
+
+    Field f = testField();
+    TracedDomain<Field, FifteenAction*> conflicts(f);
+    TracedDomain<Field, FifteenAction*> walking(f);
+    TracedDomain<Field, FifteenAction*> manhattan(f);
+
+    allPossibleActions(f, actions);
+
+    graph_plan(f, Field(3), PackedManhattanHeuristic(), actions.begin(), actions.end(), manhattan);
+    graph_plan(f, Field(3), LinearConflictHeuristic(), actions.begin(), actions.end(), conflicts);
+    graph_plan(f, Field(3), WalkingDistanceHeuristic(), actions.begin(), actions.end(), walking);
+
+    EXPECT_EQ(conflicts.actions().size(), manhattan.actions().size());
+    EXPECT_EQ(walking.actions().size(), manhattan.actions().size());
+}
+
+TEST(EightPuzzleOracle, shouldSolveOptimally) {
+    srand(30);
+
+    EightPuzzleOracle oracle;
+    oracle.generate();
+
+    PackedAStar<> planner(3);
+
+    for(unsigned i = 0; i < 100; i++) {
+        PackedField initial = randomWalk(3, 100);
+
+        std::vector<Direction> oracleMoves;
+        std::vector<Direction> plannerMoves;
+
+        ASSERT_TRUE(oracle.solve(initial, oracleMoves));
+        ASSERT_TRUE(planner.plan(initial, plannerMoves));
+
+        EXPECT_EQ(oracleMoves.size(), plannerMoves.size());
+        EXPECT_EQ(applyMoves(initial, 3, oracleMoves), packedGoal(3));
+    }
+
+    std::vector<Direction> moves;
+    PackedField unsolvable = slide(slide(packedGoal(3), 8, 7), 7, 8);
+    unsolvable = withTile(withTile(unsolvable, 0, 2), 1, 1);
+    EXPECT_FALSE(oracle.solve(unsolvable, moves));
+
+    std::vector<FifteenAction*> actions;
+    Field f = testField();
+    TracedDomain<Field, FifteenAction*> exact(f);
+    TracedDomain<Field, FifteenAction*> manhattan(f);
+
+    allPossibleActions(f, actions);
+
+    graph_plan(f, Field(3), EightPuzzleOracleHeuristic(&oracle), actions.begin(), actions.end(), exact);
+    graph_plan(f, Field(3), PackedManhattanHeuristic(), actions.begin(), actions.end(), manhattan);
+
+    EXPECT_EQ(exact.actions().size(), oracle.distance(pack(f)));
+    EXPECT_EQ(manhattan.actions().size(), oracle.distance(pack(f)));
+}
+
+TEST(SolutionCache, shouldAnswerRepeatedAndOverlappingQueries) {
+    srand(33);
+
+    SolutionCache cache(4);
+    PackedAStar<> cold(4);
+    PackedAStar<> warm(4);
+    warm.useExactDistances(&cache);
+
+    for(unsigned i = 0; i < 5; i++) {
+        PackedField initial = randomWalk(4, 80);
+
+        std::vector<Direction> moves;
+        ASSERT_TRUE(cold.plan(initial, moves));
+        cache.record(initial, moves);
+
+        std::vector<Direction> repeated;
+        ASSERT_TRUE(warm.plan(initial, repeated));
+        EXPECT_EQ(repeated, moves);
+        EXPECT_EQ(warm.expanded(), 0u);
+
+        // a few moves away from a field on the cached path
+        PackedField near = applyMoves(initial, 4, std::vector<Direction>(moves.begin(), moves.begin() + moves.size()/2));
+        for(unsigned step = 0; step < 3; step++) {
+            unsigned blank = blankAt(near, 4);
+            unsigned to = neighbour(blank, static_cast<Direction>(rand()%4), 4);
+            if(to < 16) {
+                near = slide(near, blank, to);
+            }
+        }
+
+        std::vector<Direction> coldMoves;
+        std::vector<Direction> warmMoves;
+        ASSERT_TRUE(cold.plan(near, coldMoves));
+        ASSERT_TRUE(warm.plan(near, warmMoves));
+
+        EXPECT_EQ(warmMoves.size(), coldMoves.size());
+        EXPECT_EQ(applyMoves(near, 4, warmMoves), packedGoal(4));
+        EXPECT_LE(warm.expanded(), cold.expanded());
+    }
+
+    EXPECT_GT(cache.hits(), 0u);
+}
+
+TEST(SolutionCache, shouldStayBoundedAndThreadSafe) {
+    srand(33);
+
+    SolutionCache cache(3, 64, 4);
+    EightPuzzleOracle oracle;
+    oracle.generate();
+
+    std::vector<PackedField> initials;
+    std::vector< std::vector<Direction> > solutions(32);
+    for(unsigned i = 0; i < solutions.size(); i++) {
+        initials.push_back(randomWalk(3, 100));
+        oracle.solve(initials[i], solutions[i]);
+    }
+
+    std::vector<std::thread> threads;
+    for(unsigned t = 0; t < 4; t++) {
+        threads.push_back(std::thread([&, t]() {
+            for(unsigned i = t; i < initials.size(); i += 4) {
+                cache.record(initials[i], solutions[i]);
+
+                unsigned distance;
+                Direction next;
+                if(cache.lookup(initials[i], distance, next)) {
+                    EXPECT_EQ(distance, oracle.distance(initials[i]));
+                }
+            }
+        }));
+    }
+    for(size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+
+    EXPECT_LE(cache.entries(), 64u);
+    EXPECT_GT(cache.entries(), 0u);
+}
+
+TEST(SolutionCache, shouldPlanThroughCache) {
+    std::vector<FifteenAction*> actions;
+
+    Field f = testField();
+    TracedDomain<Field, FifteenAction*> first(f);
+    TracedDomain<Field, FifteenAction*> second(f);
+
+    allPossibleActions(f, actions);
+
+    SolutionCache cache(3);
+    ASSERT_TRUE(packed_plan(f, actions.begin(), actions.end(), cache, first));
+    ASSERT_TRUE(packed_plan(f, actions.begin(), actions.end(), cache, second));
+
+    EXPECT_TRUE(second.domain() == Field(3));
+    EXPECT_EQ(second.actions(), first.actions());
+    EXPECT_EQ(cache.entries(), first.actions().size());
+}
+
+TEST(PackedDStarLite, shouldReplanAfterTheStartMoved) {
+    srand(34);
+
+    size_t replanned = 0;
+    size_t searched = 0;
+
+    for(unsigned run = 0; run < 5; run++) {
+        PackedField p = randomWalk(4, 100);
+
+        PackedDStarLite<> incremental(4);
+        std::vector<Direction> moves;
+        ASSERT_TRUE(incremental.plan(p, moves));
+        EXPECT_EQ(applyMoves(p, 4, moves), packedGoal(4));
+
+        PackedAStar<> reference(4);
+        std::vector<Direction> expected;
+        ASSERT_TRUE(reference.plan(p, expected));
+        EXPECT_EQ(moves.size(), expected.size());
+
+        // following the plan leaves nothing to repair
+        PackedField moved = applyMoves(p, 4, std::vector<Direction>(moves.begin(), moves.begin() + 2));
+        ASSERT_TRUE(incremental.plan(moved, moves));
+        EXPECT_EQ(incremental.expanded(), 0u);
+        EXPECT_EQ(moves.size(), expected.size() - 2);
+
+        unsigned blank = blankAt(moved, 4);
+        unsigned to = neighbour(blank, static_cast<Direction>(rand()%4), 4);
+        if(to < 16) {
+            moved = slide(moved, blank, to);
+        }
+
+        ASSERT_TRUE(incremental.plan(moved, moves));
+        replanned += incremental.expanded();
+        EXPECT_EQ(applyMoves(moved, 4, moves), packedGoal(4));
+
+        PackedDStarLite<> fresh(4);
+        ASSERT_TRUE(fresh.plan(moved, expected));
+        searched += fresh.expanded();
+        EXPECT_EQ(moves.size(), expected.size());
+    }
+
+    EXPECT_LT(replanned, searched/2);
+}
+
+struct BlockedMoves {
+    std::set< std::pair<PackedField, PackedField> > blocked;
+
+    Cost operator()(PackedField from, PackedField to) const {
+        if(blocked.count(std::make_pair(std::min(from, to), std::max(from, to)))) {
+            return PackedDStarLite<BlockedMoves>::Blocked;
+        }
+
+        return 1;
+    }
+};
+
+TEST(PackedDStarLite, shouldRepairAfterCostsChanged) {
+    srand(35);
+
+    PackedField p = randomWalk(3, 40);
+
+    PackedDStarLite<BlockedMoves> incremental(3);
+    std::vector<Direction> moves;
+    ASSERT_TRUE(incremental.plan(p, moves));
+    ASSERT_FALSE(moves.empty());
+
+    unsigned exits = 0;
+    for(unsigned d = Up; d <= Right; d++) {
+        exits += neighbour(blankAt(p, 3), static_cast<Direction>(d), 3) < 9;
+    }
+
+    for(unsigned i = 0; i + 1 < exits; i++) {
+        PackedField next = applyMoves(p, 3, std::vector<Direction>(moves.begin(), moves.begin() + 1));
+        incremental.edgeCost().blocked.insert(std::make_pair(std::min(p, next), std::max(p, next)));
+        incremental.costChanged(p, next);
+
+        std::vector<Direction> repaired;
+        ASSERT_TRUE(incremental.plan(p, repaired));
+        EXPECT_EQ(applyMoves(p, 3, repaired), packedGoal(3));
+        EXPECT_NE(applyMoves(p, 3, std::vector<Direction>(repaired.begin(), repaired.begin() + 1)), next);
+
+        PackedDStarLite<BlockedMoves> fresh(3, incremental.edgeCost());
+        ASSERT_TRUE(fresh.plan(p, moves));
+        EXPECT_EQ(repaired.size(), moves.size());
+        moves = repaired;
+    }
+}
+
+TEST(Perimeter, shouldKnowEveryNearFieldWithAWayToTheGoal) {
+    Perimeter perimeter(4, 10);
+    EXPECT_EQ(perimeter.depth(), 10u);
+
+    srand(46);
+    for(unsigned i = 0; i < 300; i++) {
+        PackedField p = randomWalk(4, rand() % 11);
+
+        unsigned distance;
+        Direction next;
+        ASSERT_TRUE(perimeter.lookup(p, distance, next));
+        EXPECT_LE(distance, 10u);
+
+        for(unsigned left = distance; left > 0; left--) {
+            unsigned d;
+            ASSERT_TRUE(perimeter.lookup(p, d, next));
+            EXPECT_EQ(d, left);
+            p = applyMoves(p, 4, std::vector<Direction>(1, next));
+        }
+        EXPECT_EQ(p, packedGoal(4));
+    }
+
+    PackedField far = randomWalk(4, 500);
+    PackedAStar<> planner(4);
+    std::vector<Direction> moves;
+    ASSERT_TRUE(planner.plan(far, moves));
+
+    unsigned distance;
+    Direction next;
+    EXPECT_EQ(perimeter.lookup(far, distance, next), moves.size() <= 10);
+
+    const char* path = "perimeter_test.bin";
+    ASSERT_TRUE(perimeter.save(path));
+
+    Perimeter loaded(4);
+    ASSERT_TRUE(loaded.load(path));
+    EXPECT_EQ(loaded.fields(), perimeter.fields());
+    EXPECT_EQ(loaded.depth(), perimeter.depth());
+
+    Perimeter other(3);
+    EXPECT_FALSE(other.load(path));
+
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write(bytes.data(), bytes.size()-1);
+    }
+    EXPECT_FALSE(loaded.load(path));
+
+    uint32_t depth = 1000;
+    bytes.replace(12, sizeof(depth), reinterpret_cast<const char*>(&depth), sizeof(depth));
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write(bytes.data(), bytes.size());
+    }
+    EXPECT_FALSE(loaded.load(path));
+
+    EXPECT_EQ(loaded.fields(), perimeter.fields());
+    EXPECT_EQ(loaded.depth(), perimeter.depth());
+    unsigned d;
+    EXPECT_TRUE(loaded.lookup(packedGoal(4), d, next));
+    EXPECT_EQ(d, 0u);
+    remove(path);
+}
+
+TEST(Perimeter, shouldShortenSearchesSharedByThreads) {
+    const Perimeter perimeter(4, 14);
+
+    srand(47);
+    std::vector<PackedField> instances;
+    for(unsigned i = 0; i < 8; i++) {
+        instances.push_back(randomWalk(4, 200));
+    }
+
+    std::vector<size_t> expected(instances.size());
+    size_t plainExpanded = 0;
+    for(size_t i = 0; i < instances.size(); i++) {
+        PackedAStar<> plain(4);
+        std::vector<Direction> moves;
+        ASSERT_TRUE(plain.plan(instances[i], moves));
+        expected[i] = moves.size();
+        plainExpanded += plain.expanded();
+    }
+
+    std::vector<size_t> found(instances.size());
+    std::vector<size_t> expanded(instances.size());
+    std::vector<std::thread> threads;
+    for(unsigned t = 0; t < 2; t++) {
+        threads.push_back(std::thread([&, t]() {
+            for(size_t i = t; i < instances.size(); i += 2) {
+                PackedAStar< PerimeterHeuristic<> > planner(4, 64, PerimeterHeuristic<>(&perimeter));
+                planner.useExactDistances(&perimeter);
+
+                std::vector<Direction> moves;
+                if(planner.plan(instances[i], moves) && applyMoves(instances[i], 4, moves) == packedGoal(4)) {
+                    found[i] = moves.size();
+                }
+                expanded[i] = planner.expanded();
+            }
+        }));
+    }
+    for(size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+
+    size_t perimeterExpanded = 0;
+    for(size_t i = 0; i < instances.size(); i++) {
+        EXPECT_EQ(found[i], expected[i]);
+        perimeterExpanded += expanded[i];
+    }
+    EXPECT_LT(perimeterExpanded, plainExpanded);
+
+    std::vector<FifteenAction*> actions;
+    Field f = testField();
+    allPossibleActions(f, actions);
+
+    const Perimeter whole(2, 1000);
+    EXPECT_EQ(whole.fields(), 12u);
+    EXPECT_EQ(whole.depth(), 6u);
+
+    const Perimeter small(3, 12);
+    TracedDomain<Field, FifteenAction*> reference(f);
+    TracedDomain<Field, FifteenAction*> solution(f);
+    ASSERT_TRUE(packed_plan(f, actions.begin(), actions.end(), reference));
+    ASSERT_TRUE(packed_plan(f, actions.begin(), actions.end(), small, solution));
+    EXPECT_TRUE(solution.domain() == Field(3));
+    EXPECT_EQ(solution.actions().size(), reference.actions().size());
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,255 @@
+#ifndef PERIMETER_H
+#define PERIMETER_H
+
+#include "packed.h"
+#include "closedset.h"
+#include "packedastar.h"
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <boost/utility.hpp>
+
+/**
+ * @brief Every field (up to 4x4) at most `depth` moves away from
+ *        Field(size), with its distance and the next move towards the goal,
+ *        found by a breadth-first search from the goal.
+ *
+ * Built once (or loaded) and only read afterwards, so any number of threads
+ * may search with it at the same time.
+ */
+class Perimeter: public ExactDistances, public boost::noncopyable
+{
+    static const char* magic() {
+        return "FIFPERIM";
+    }
+
+    static uint32_t encode(unsigned distance, unsigned next) {
+        return distance | (next << 16);
+    }
+
+    const unsigned fieldSize;
+    unsigned radius;
+    ClosedSet<PackedField, uint32_t> table;
+    std::vector<PackedField> order;
+
+public:
+
+    explicit Perimeter(unsigned _size):
+        fieldSize(_size),
+        radius(0),
+        table(),
+        order()
+    {
+        assert(fieldSize <= MaxPackedSize);
+    }
+
+    Perimeter(unsigned _size, unsigned depth):
+        fieldSize(_size),
+        radius(0),
+        table(),
+        order()
+    {
+        assert(fieldSize <= MaxPackedSize);
+        build(depth);
+    }
+
+    /**
+     * @brief Up to `depth` moves, or as far as fields of this size reach
+     */
+    void build(unsigned depth) {
+        const PackedField goal = packedGoal(fieldSize);
+
+        table.clear();
+        order.assign(1, goal);
+        table.insert(goal, encode(0, 0));
+        radius = 0;
+
+        size_t begin = 0;
+        for(unsigned distance = 1; distance <= depth && begin < order.size(); distance++) {
+            const size_t end = order.size();
+
+            for(size_t i = begin; i < end; i++) {
+                const PackedField p = order[i];
+                const unsigned blank = blankAt(p, fieldSize);
+
+                for(unsigned d = Up; d <= Right; d++) {
+                    unsigned to = neighbour(blank, static_cast<Direction>(d), fieldSize);
+                    if(to >= fieldSize*fieldSize) {
+                        continue;
+                    }
+
+                    PackedField child = slide(p, blank, to);
+                    if(table.find(child) == ClosedSet<PackedField, uint32_t>::NotFound) {
+                        table.insert(child, encode(distance, inverse(static_cast<Direction>(d))));
+                        order.push_back(child);
+                    }
+                }
+            }
+
+            begin = end;
+            if(order.size() > end) {
+                radius = distance;
+            }
+        }
+    }
+
+    unsigned size() const {
+        return fieldSize;
+    }
+
+    unsigned depth() const {
+        return radius;
+    }
+
+    size_t fields() const {
+        return order.size();
+    }
+
+    bool lookup(PackedField p, unsigned& distance, Direction& next) const {
+        uint32_t value = table.find(p);
+        if(value == ClosedSet<PackedField, uint32_t>::NotFound) {
+            return false;
+        }
+
+        distance = value & 0xFFFF;
+        next = static_cast<Direction>(value >> 16);
+        return true;
+    }
+
+    /**
+     * @brief Header, size, depth and count, then every field with its value
+     */
+    bool save(const char* path) const {
+        std::ofstream out(path, std::ios::binary);
+
+        const uint32_t header[3] = {fieldSize, radius, uint32_t(order.size())};
+        out.write(magic(), 8);
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+        for(size_t i = 0; i < order.size(); i++) {
+            const uint32_t value = table.find(order[i]);
+            out.write(reinterpret_cast<const char*>(&order[i]), sizeof(PackedField));
+            out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+
+        return out.good();
+    }
+
+    /**
+     * @brief False if the file is not a complete perimeter of this size, the
+     *        perimeter is then left as it was
+     */
+    bool load(const char* path) {
+        std::ifstream in(path, std::ios::binary);
+
+        char name[8];
+        uint32_t header[3];
+        in.read(name, 8);
+        in.read(reinterpret_cast<char*>(header), sizeof(header));
+        if(!in || memcmp(name, magic(), 8) != 0 || header[0] != fieldSize) {
+            return false;
+        }
+
+        // every level up to the depth holds a field, the deepest is the
+        // depth, and the records have to fill the rest of the file exactly
+        const uint64_t record = sizeof(PackedField) + sizeof(uint32_t);
+        const std::streamoff start = in.tellg();
+        in.seekg(0, std::ios::end);
+        const uint64_t left = in.tellg() - start;
+        in.seekg(start);
+        if(header[1] > 0xFFFF || header[2] <= header[1] || left != header[2]*record) {
+            return false;
+        }
+
+        ClosedSet<PackedField, uint32_t> loadedTable(header[2]);
+        std::vector<PackedField> loadedOrder;
+        loadedOrder.reserve(header[2]);
+        unsigned deepest = 0;
+
+        for(uint32_t i = 0; i < header[2]; i++) {
+            PackedField p;
+            uint32_t value;
+            in.read(reinterpret_cast<char*>(&p), sizeof(p));
+            in.read(reinterpret_cast<char*>(&value), sizeof(value));
+            if(!in || p == 0 || (value & 0xFFFF) > header[1]) {
+                return false;
+            }
+
+            loadedTable.insert(p, value);
+            loadedOrder.push_back(p);
+            deepest = std::max(deepest, value & 0xFFFF);
+        }
+        if(deepest != header[1] || loadedTable.find(packedGoal(fieldSize)) != encode(0, 0)) {
+            return false;
+        }
+
+        table.swap(loadedTable);
+        order.swap(loadedOrder);
+        radius = header[1];
+
+        return true;
+    }
+};
+
+/**
+ * @brief Batch heuristic tightened by a perimeter: exact inside it, and at
+ *        least one more than its depth outside, which stays consistent
+ */
+template<typename BatchHeuristic = PackedManhattan>
+struct PerimeterHeuristic {
+    const Perimeter* perimeter;
+    BatchHeuristic heuristic;
+
+    PerimeterHeuristic(const Perimeter* _perimeter, const BatchHeuristic& _heuristic = BatchHeuristic()):
+        perimeter(_perimeter),
+        heuristic(_heuristic)
+    {}
+
+    void operator()(const PackedField* fields, Cost* costs, size_t count, unsigned size) const {
+        heuristic(fields, costs, count, size);
+
+        for(size_t i = 0; i < count; i++) {
+            unsigned distance;
+            Direction next;
+
+            if(perimeter->lookup(fields[i], distance, next)) {
+                costs[i] = distance;
+            } else {
+                costs[i] = std::max<Cost>(costs[i], perimeter->depth()+1);
+            }
+        }
+    }
+};
+
+/**
+ * @brief packed_plan that stops on touching `perimeter` and is guided by
+ *        its PerimeterHeuristic
+ */
+template <typename ActionPtr, typename ActionsIterator>
+bool packed_plan(
+        const Field& initial,
+        const ActionsIterator actionsBegin,
+        const ActionsIterator actionsEnd,
+        const Perimeter& perimeter,
+        TracedDomain<Field, ActionPtr>& history
+        ) {
+
+    assert(perimeter.size() == initial.size);
+
+    PackedAStar< PerimeterHeuristic<> > planner(initial.size, 64, PerimeterHeuristic<>(&perimeter));
+    planner.useExactDistances(&perimeter);
+
+    std::vector<Direction> moves;
+    if(!planner.plan(pack(initial), moves)) {
+        return false;
+    }
+
+    history = TracedDomain<Field, ActionPtr>(initial);
+    replay(moves, actionsBegin, actionsEnd, history);
+
+    return true;
+}
+
+#endif // PERIMETER_H
@@ -0,0 +1,158 @@
+#ifndef SOLUTIONCACHE_H
+#define SOLUTIONCACHE_H
+
+#include "packed.h"
+#include "packedastar.h"
+#include <stdint.h>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <boost/utility.hpp>
+
+/**
+ * @brief Exact distance to Field(size) and the next move for every field on
+ *        optimal solutions found so far.
+ *
+ * Every subpath of an optimal path is optimal, so recording one solution
+ * makes all the fields along it solved. Fields are spread over shards by
+ * hash, each shard has its own lock and evicts its oldest entries beyond
+ * `capacity/shards` of them.
+ */
+class SolutionCache: public ExactDistances, public boost::noncopyable
+{
+    struct Entry {
+        uint16_t distance;
+        uint8_t next;
+    };
+
+    struct Shard {
+        std::mutex lock;
+        std::unordered_map<PackedField, Entry> entries;
+        std::deque<PackedField> order;
+    };
+
+    const unsigned fieldSize;
+    const size_t shardCapacity;
+    mutable std::vector<Shard> shards;
+
+    mutable std::atomic<size_t> hitCount;
+    mutable std::atomic<size_t> missCount;
+
+    Shard& shard(PackedField p) const {
+        return shards[hashPacked(p) % shards.size()];
+    }
+
+public:
+
+    SolutionCache(unsigned _size, size_t capacity = 1 << 20, unsigned shardCount = 16):
+        fieldSize(_size),
+        shardCapacity(std::max<size_t>(1, capacity/shardCount)),
+        shards(shardCount),
+        hitCount(0),
+        missCount(0)
+    {
+        assert(shardCount > 0);
+    }
+
+    unsigned size() const {
+        return fieldSize;
+    }
+
+    bool lookup(PackedField p, unsigned& distance, Direction& next) const {
+        Shard& s = shard(p);
+        std::lock_guard<std::mutex> guard(s.lock);
+
+        std::unordered_map<PackedField, Entry>::const_iterator it = s.entries.find(p);
+        if(it == s.entries.end()) {
+            missCount++;
+            return false;
+        }
+
+        hitCount++;
+        distance = it->second.distance;
+        next = static_cast<Direction>(it->second.next);
+        return true;
+    }
+
+    /**
+     * @brief Records every field on the optimal solution `moves` of `initial`
+     */
+    void record(PackedField initial, const std::vector<Direction>& moves) {
+        PackedField p = initial;
+
+        for(size_t i = 0; i < moves.size(); i++) {
+            Entry e;
+            e.distance = moves.size() - i;
+            e.next = moves[i];
+
+            Shard& s = shard(p);
+            {
+                std::lock_guard<std::mutex> guard(s.lock);
+
+                if(s.entries.insert(std::make_pair(p, e)).second) {
+                    s.order.push_back(p);
+
+                    if(s.order.size() > shardCapacity) {
+                        s.entries.erase(s.order.front());
+                        s.order.pop_front();
+                    }
+                }
+            }
+
+            unsigned blank = blankAt(p, fieldSize);
+            p = slide(p, blank, neighbour(blank, moves[i], fieldSize));
+        }
+    }
+
+    size_t entries() const {
+        size_t count = 0;
+        for(size_t i = 0; i < shards.size(); i++) {
+            std::lock_guard<std::mutex> guard(shards[i].lock);
+            count += shards[i].entries.size();
+        }
+
+        return count;
+    }
+
+    size_t hits() const {
+        return hitCount;
+    }
+
+    size_t misses() const {
+        return missCount;
+    }
+};
+
+/**
+ * @brief packed_plan that answers from `cache` when it can and records the
+ *        solution found into it
+ */
+template <typename ActionPtr, typename ActionsIterator>
+bool packed_plan(
+        const Field& initial,
+        const ActionsIterator actionsBegin,
+        const ActionsIterator actionsEnd,
+        SolutionCache& cache,
+        TracedDomain<Field, ActionPtr>& history
+        ) {
+
+    assert(cache.size() == initial.size);
+
+    PackedAStar<> planner(initial.size);
+    planner.useExactDistances(&cache);
+
+    std::vector<Direction> moves;
+    if(!planner.plan(pack(initial), moves)) {
+        return false;
+    }
+    cache.record(pack(initial), moves);
+
+    history = TracedDomain<Field, ActionPtr>(initial);
+    replay(moves, actionsBegin, actionsEnd, history);
+
+    return true;
+}
+
+#endif // SOLUTIONCACHE_H
@@ -0,0 +1,327 @@
+#ifndef STAGED_H
+#define STAGED_H
+
+#include "astar.h"
+#include "model.h"
+#include <stdlib.h>
+#include <vector>
+#include <chrono>
+#include <boost/utility.hpp>
+
+namespace staged {
+
+/**
+ * @brief Field where only `relevant` tiles keep their values, all others are
+ *        the same tile `size*size`, so fields differing in them are equal
+ */
+inline Field abstraction(const Field& f, const std::vector<bool>& relevant) {
+    const unsigned other = f.size*f.size;
+
+    std::vector<Place> places;
+    for(Field::const_iterator it = f.begin(); it != f.end(); ++it) {
+        if(it->vacant()) {
+            places.push_back(Place(it->position));
+        } else {
+            unsigned value = it->tileMaybe.get().value;
+            places.push_back(Place(it->position, Tile(relevant[value] ? value : other)));
+        }
+    }
+
+    return Field(places);
+}
+
+inline Position moved(const Position& from, Direction d) {
+    return Position(from.row + (d == Down) - (d == Up), from.column + (d == Right) - (d == Left));
+}
+
+}
+
+/**
+ * @brief Every relevant tile of an abstraction is at its place
+ */
+struct RelevantInPlace: std::unary_function<const Field&, bool> {
+    bool operator()(const Field& f) const {
+        const unsigned other = f.size*f.size;
+
+        for(Field::const_iterator it = f.begin(); it != f.end(); ++it) {
+            if(it->occupied()) {
+                unsigned value = it->tileMaybe.get().value;
+                if(value != other && unsigned(it->position.row*f.size + it->position.column + 1) != value) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+};
+
+/**
+ * @brief Manhattan distance of relevant tiles of an abstraction, times
+ *        `weight`, optionally plus how far the vacant place is from the
+ *        nearest misplaced one (which keeps it from wandering, but is not
+ *        admissible)
+ */
+struct RelevantManhattan: std::unary_function<const Field&, Cost> {
+    Cost weight;
+    bool guideVacant;
+
+    RelevantManhattan(Cost _weight = 1, bool _guideVacant = false):
+        weight(_weight),
+        guideVacant(_guideVacant)
+    {}
+
+    Cost operator()(const Field& f) const {
+        const unsigned other = f.size*f.size;
+
+        int vacantRow = 0;
+        int vacantColumn = 0;
+        for(Field::const_iterator it = f.begin(); it != f.end(); ++it) {
+            if(it->vacant()) {
+                vacantRow = it->position.row;
+                vacantColumn = it->position.column;
+            }
+        }
+
+        Cost sum = 0;
+        Cost nearest = 0;
+        for(Field::const_iterator it = f.begin(); it != f.end(); ++it) {
+            if(it->occupied() && it->tileMaybe.get().value != other) {
+                int value = it->tileMaybe.get().value - 1;
+                Cost distance = abs(it->position.row - value/int(f.size)) + abs(it->position.column - value%int(f.size));
+
+                if(distance > 0) {
+                    Cost away = abs(it->position.row - vacantRow) + abs(it->position.column - vacantColumn) - 1;
+                    nearest = sum == 0 ? away : std::min(nearest, away);
+                }
+                sum += distance;
+            }
+        }
+
+        return weight*sum + (guideVacant ? nearest : 0);
+    }
+};
+
+/**
+ * @brief Suboptimal solver for boards too large for optimal search.
+ *
+ * The top row and then the left column of the board are placed and frozen,
+ * and the same is repeated on the smaller board left, until it is 3x3 and
+ * solved optimally. Every stage is a bounded weighted A* over the unfrozen
+ * places on an abstraction keeping only the tiles being placed, so earlier
+ * stages are never disturbed and stages stay small.
+ */
+template<typename ActionPtr>
+class StagedSolver: public boost::noncopyable
+{
+public:
+    struct Stage {
+        unsigned tiles;
+        size_t moves;
+        size_t expanded;
+        double seconds;
+    };
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    const size_t nodeBound;
+    const Cost weight;
+    std::vector<Stage> done;
+
+    unsigned size;
+    std::vector<bool> frozen;
+
+    template<typename ActionsIterator>
+    bool stage(
+            const std::vector<bool>& relevant,
+            unsigned tiles,
+            ActionsIterator actionsBegin,
+            ActionsIterator actionsEnd,
+            TracedDomain<Field, ActionPtr>& history,
+            Cost stageWeight) {
+
+        Clock::time_point started = Clock::now();
+
+        std::vector<ActionPtr> region;
+        for(ActionsIterator it = actionsBegin; it != actionsEnd; ++it) {
+            if(movable((**it).from()) && movable(staged::moved((**it).from(), (**it).direction()))) {
+                region.push_back(*it);
+            }
+        }
+
+        Field abstract = staged::abstraction(history.domain(), relevant);
+
+        Stage stage;
+        stage.tiles = tiles;
+        stage.expanded = 0;
+
+        GenericAStar<
+                Field,
+                ActionPtr,
+                BoundedGraphVisitor<Field>,
+                typename std::vector<ActionPtr>::const_iterator,
+                RelevantInPlace,
+                RelevantManhattan
+                >
+                planner(abstract, region.begin(), region.end(), RelevantInPlace(), RelevantManhattan(stageWeight, stageWeight > 1),
+                        PathCost<Field, ActionPtr>(), BoundedGraphVisitor<Field>(nodeBound, &stage.expanded));
+
+        TracedDomain<Field, ActionPtr> found(abstract);
+        if(!planner.plan(found)) {
+            return false;
+        }
+
+        for(size_t a = 0; a < found.actions().size(); a++) {
+            history.accept(found.actions()[a]);
+        }
+
+        stage.moves = found.actions().size();
+        stage.seconds = std::chrono::duration<double>(Clock::now() - started).count();
+        done.push_back(stage);
+
+        return true;
+    }
+
+    /**
+     * @brief Places `line` tile by tile freezing each but the last two, which
+     *        can only be placed together in one stage, or places all of it in
+     *        one stage
+     */
+    template<typename ActionsIterator>
+    bool place(
+            const std::vector<unsigned>& line,
+            bool oneByOne,
+            ActionsIterator actionsBegin,
+            ActionsIterator actionsEnd,
+            TracedDomain<Field, ActionPtr>& history,
+            Cost stageWeight) {
+
+        std::vector<bool> relevant(size*size + 1, false);
+        unsigned tiles = 0;
+
+        for(size_t i = 0; i < line.size(); i++) {
+            relevant[line[i]] = true;
+            tiles++;
+
+            if(i+1 < line.size() && (!oneByOne || i+2 == line.size())) {
+                continue;
+            }
+
+            if(!stage(relevant, tiles, actionsBegin, actionsEnd, history, stageWeight)) {
+                return false;
+            }
+
+            if(oneByOne && i+2 < line.size()) {
+                relevant[line[i]] = false;
+                frozen[line[i]-1] = true;
+                tiles--;
+            }
+        }
+
+        for(size_t i = 0; i < line.size(); i++) {
+            frozen[line[i]-1] = true;
+        }
+
+        return true;
+    }
+
+    bool movable(const Position& pos) const {
+        return pos.row >= 0 && pos.column >= 0 && pos.row < int(size) && pos.column < int(size) && !frozen[pos.row*size + pos.column];
+    }
+
+public:
+
+    StagedSolver(size_t _nodeBound = 1 << 18, Cost _weight = 2):
+        nodeBound(_nodeBound),
+        weight(_weight),
+        done(),
+        size(0),
+        frozen()
+    {}
+
+    /**
+     * @brief Solves `history.domain()` by appending actions to `history`,
+     *        false if some stage did not succeed within the node bound
+     */
+    template<typename ActionsIterator>
+    bool solve(ActionsIterator actionsBegin, ActionsIterator actionsEnd, TracedDomain<Field, ActionPtr>& history) {
+        size = history.domain().size;
+        frozen.assign(size*size, false);
+        done.clear();
+
+        unsigned k = 0;
+        for(; size - k > 3; k++) {
+            std::vector<unsigned> row;
+            for(unsigned c = k; c < size; c++) {
+                row.push_back(k*size + c + 1);
+            }
+            if(!place(row, true, actionsBegin, actionsEnd, history, weight)) {
+                return false;
+            }
+
+            std::vector<unsigned> column;
+            for(unsigned r = k+1; r < size; r++) {
+                column.push_back(r*size + k + 1);
+            }
+            if(!place(column, true, actionsBegin, actionsEnd, history, weight)) {
+                return false;
+            }
+        }
+
+        std::vector<unsigned> rest;
+        for(unsigned r = k; r < size; r++) {
+            for(unsigned c = k; c < size; c++) {
+                if(r*size + c + 1 < size*size) {
+                    rest.push_back(r*size + c + 1);
+                }
+            }
+        }
+
+        return place(rest, false, actionsBegin, actionsEnd, history, 1);
+    }
+
+    /**
+     * @brief Tiles, moves, expansions and time of every stage of the last solve
+     */
+    const std::vector<Stage>& stages() const {
+        return done;
+    }
+
+    size_t moves() const {
+        size_t sum = 0;
+        for(size_t i = 0; i < done.size(); i++) {
+            sum += done[i].moves;
+        }
+
+        return sum;
+    }
+
+    double seconds() const {
+        double sum = 0;
+        for(size_t i = 0; i < done.size(); i++) {
+            sum += done[i].seconds;
+        }
+
+        return sum;
+    }
+};
+
+/**
+ * @brief Suboptimal plan for boards of any size, see StagedSolver
+ */
+template <typename ActionPtr, typename ActionsIterator>
+bool staged_plan(
+        const Field& initial,
+        const ActionsIterator actionsBegin,
+        const ActionsIterator actionsEnd,
+        TracedDomain<Field, ActionPtr>& history
+        ) {
+
+    StagedSolver<ActionPtr> solver;
+
+    history = TracedDomain<Field, ActionPtr>(initial);
+    return solver.solve(actionsBegin, actionsEnd, history);
+}
+
+#endif // STAGED_H
@@ -0,0 +1,40 @@
+#include "model.h"
+#include "actions.h"
+#include "staged.h"
+#include "generator.h"
+#include <iostream>
+#include <stdlib.h>
+
+int main(int argc, char** argv) {
+    if(argc < 2) {
+        std::cerr<<"usage: "<<argv[0]<<" <size> [shuffle steps] [seed]"<<std::endl;
+        return 1;
+    }
+
+    unsigned size = atoi(argv[1]);
+    unsigned steps = argc > 2 ? atoi(argv[2]) : 100000;
+    unsigned seed = argc > 3 ? atoi(argv[3]) : 1;
+
+    Field f = InstanceGenerator(size, seed).shuffled(steps);
+    std::cout<<"Solving: "<<std::endl<<f;
+
+    std::vector<FifteenAction*> actions;
+    allPossibleActions(f, actions);
+
+    StagedSolver<FifteenAction*> solver;
+    TracedDomain<Field, FifteenAction*> history(f);
+    bool solved = solver.solve(actions.begin(), actions.end(), history);
+
+    for(size_t i = 0; i < solver.stages().size(); i++) {
+        const StagedSolver<FifteenAction*>::Stage& s = solver.stages()[i];
+        std::cout<<"stage "<<i<<": "<<s.tiles<<" tiles, "<<s.moves<<" moves, "<<s.expanded<<" expanded, "<<s.seconds<<"s"<<std::endl;
+    }
+
+    if(!solved) {
+        std::cout<<"not solved within the node bound"<<std::endl;
+        return 1;
+    }
+
+    std::cout<<solver.moves()<<" moves in "<<solver.seconds()<<"s"<<std::endl;
+    return 0;
+}
@@ -0,0 +1,161 @@
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include "model.h"
+#include "packed.h"
+#include "closedset.h"
+#include "astar.h"
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <unordered_set>
+
+/**
+ * Field(size) is symmetric about the main diagonal: the place at row r,
+ * column c goes to row c, column r and the tile belonging at (r, c) is
+ * relabelled to the one belonging at (c, r). The vacant place stays on the
+ * diagonal, so a field and its mirror are equally far from the goal.
+ */
+namespace symmetry {
+
+inline unsigned mirrorTile(unsigned tile, unsigned size) {
+    return tile == 0 ? 0 : ((tile-1)%size)*size + (tile-1)/size + 1;
+}
+
+inline unsigned value(const Place& p) {
+    return p.tileMaybe.get_value_or(Tile(0)).value;
+}
+
+}
+
+inline Field mirror(const Field& f) {
+    const unsigned size = f.size;
+
+    std::vector<unsigned> tiles;
+    for(Field::const_iterator it = f.begin(); it != f.end(); ++it) {
+        tiles.push_back(symmetry::value(*it));
+    }
+
+    std::vector<Place> places;
+    for(unsigned row = 0; row < size; row++) {
+        for(unsigned column = 0; column < size; column++) {
+            unsigned tile = symmetry::mirrorTile(tiles[column*size + row], size);
+
+            if(tile == 0) {
+                places.push_back(Place(Position(row, column)));
+            } else {
+                places.push_back(Place(Position(row, column), Tile(tile)));
+            }
+        }
+    }
+
+    return Field(places);
+}
+
+inline PackedField mirror(PackedField p, unsigned size) {
+    PackedField m = 0;
+    for(unsigned row = 0; row < size; row++) {
+        for(unsigned column = 0; column < size; column++) {
+            m = withTile(m, row*size + column, symmetry::mirrorTile(tileAt(p, column*size + row), size));
+        }
+    }
+
+    return m;
+}
+
+/**
+ * @brief Tiles of `a` in place order are lexicographically smaller than of `b`
+ */
+inline bool precedes(const Field& a, const Field& b) {
+    Field::const_iterator i = a.begin();
+    Field::const_iterator j = b.begin();
+
+    for(; i != a.end() && j != b.end(); ++i, ++j) {
+        if(symmetry::value(*i) != symmetry::value(*j)) {
+            return symmetry::value(*i) < symmetry::value(*j);
+        }
+    }
+
+    return j != b.end();
+}
+
+/**
+ * @brief The one of a field and its mirror representing both
+ */
+inline Field canonical(const Field& f) {
+    Field m = mirror(f);
+    return precedes(m, f) ? m : f;
+}
+
+inline PackedField canonical(PackedField p, unsigned size) {
+    return std::min(p, mirror(p, size));
+}
+
+/**
+ * @brief Maximum of a heuristic on a field and on its mirror, admissible if
+ *        the heuristic is, and better informed if it is not symmetric itself
+ *        (pattern databases of some tiles)
+ */
+template<typename Heuristic>
+struct MirroredMax: std::unary_function<const Field&, Cost> {
+    Heuristic heuristic;
+
+    MirroredMax(const Heuristic& _heuristic = Heuristic()):
+        heuristic(_heuristic)
+    {}
+
+    Cost operator()(const Field& f) const {
+        return std::max(heuristic(f), heuristic(mirror(f)));
+    }
+};
+
+/**
+ * @brief MirroredMax of a batch heuristic of PackedAStar
+ */
+template<typename BatchHeuristic>
+struct PackedMirroredMax {
+    BatchHeuristic heuristic;
+
+    PackedMirroredMax(const BatchHeuristic& _heuristic = BatchHeuristic()):
+        heuristic(_heuristic)
+    {}
+
+    void operator()(const PackedField* fields, Cost* costs, size_t count, unsigned size) const {
+        std::vector<PackedField> mirrors(count);
+        std::vector<Cost> mirrored(count);
+
+        for(size_t i = 0; i < count; i++) {
+            mirrors[i] = mirror(fields[i], size);
+        }
+
+        heuristic(fields, costs, count, size);
+        heuristic(&mirrors[0], &mirrored[0], count, size);
+
+        for(size_t i = 0; i < count; i++) {
+            costs[i] = std::max(costs[i], mirrored[i]);
+        }
+    }
+};
+
+/**
+ * @brief GenericAStar visitor keeping the best g of every symmetry class of
+ *        fields (up to 4x4) in a ClosedSet: a field is dropped if it or its
+ *        mirror, equally far from the goal, was reached at no greater cost
+ */
+template<typename Domain>
+struct CanonicalClosedVisitor {
+    ClosedSet<PackedField, Cost>* closed;
+
+    CanonicalClosedVisitor(ClosedSet<PackedField, Cost>* _closed):
+        closed(_closed)
+    {}
+
+    void operator()(const Domain& d, std::unordered_set<Domain>& closed_set) {
+    }
+
+    bool visited(const Domain& d, Cost g, const std::unordered_set<Domain>& closed_set) {
+        return !closed->improve(canonical(pack(d), d.size), g);
+    }
+};
+
+#endif // SYMMETRY_H
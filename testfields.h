@@ -0,0 +1,46 @@
+#ifndef TESTFIELDS_H
+#define TESTFIELDS_H
+
+#include "model.h"
+#include "packed.h"
+#include <stdlib.h>
+
+/**
+ * @brief 3x3 field the searches are checked on
+ */
+inline Field testField() {
+    std::vector<Place> p;
+
+    p.push_back(Place(Position(0,0), Tile(8)));
+    p.push_back(Place(Position(0,1), Tile(1)));
+    p.push_back(Place(Position(0,2), Tile(7)));
+    p.push_back(Place(Position(1,0), Tile(4)));
+    p.push_back(Place(Position(1,1), Tile(5)));
+    p.push_back(Place(Position(1,2), Tile(6)));
+    p.push_back(Place(Position(2,0), Tile(2)));
+    p.push_back(Place(Position(2,1)));
+    p.push_back(Place(Position(2,2), Tile(3)));
+
+    return Field(p);
+}
+
+/**
+ * @brief `steps` random moves of the vacant place from the goal, ones off
+ *        the board skipped, reproducible through srand
+ */
+inline PackedField randomWalk(unsigned size, unsigned steps) {
+    PackedField p = packedGoal(size);
+    unsigned blank = blankAt(p, size);
+
+    for(unsigned i = 0; i < steps; i++) {
+        unsigned to = neighbour(blank, static_cast<Direction>(rand()%4), size);
+        if(to < size*size) {
+            p = slide(p, blank, to);
+            blank = to;
+        }
+    }
+
+    return p;
+}
+
+#endif // TESTFIELDS_H
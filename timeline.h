@@ -0,0 +1,184 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <vector>
+#include <chrono>
+#include <ostream>
+#include <boost/utility.hpp>
+#include "cost.h"
+
+/**
+ * @brief Samples of how a search evolves, taken at most once per interval.
+ *
+ * A search asks due() on every expansion (or batch) and only then gathers
+ * and records a sample; due() reads the clock once per `stride` calls, so
+ * in between it is a counter decrement.
+ */
+class SearchTimeline: public boost::noncopyable
+{
+public:
+    struct Sample {
+        double seconds;
+        size_t open;
+        size_t closed;
+        Cost f;
+        size_t expanded;
+        size_t residentBytes;
+    };
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    const double interval;
+    const unsigned stride;
+    unsigned countdown;
+    Clock::time_point started;
+    double last;
+    std::vector<Sample> taken;
+
+    static size_t residentBytes() {
+        long pages = 0;
+        long resident = 0;
+
+        FILE* statm = fopen("/proc/self/statm", "r");
+        if(statm == 0) {
+            return 0;
+        }
+        if(fscanf(statm, "%ld %ld", &pages, &resident) != 2) {
+            resident = 0;
+        }
+        fclose(statm);
+
+        return size_t(resident)*sysconf(_SC_PAGESIZE);
+    }
+
+    double now() const {
+        return std::chrono::duration<double>(Clock::now() - started).count();
+    }
+
+public:
+
+    explicit SearchTimeline(double _interval = 0.01, unsigned _stride = 64):
+        interval(_interval),
+        stride(_stride > 0 ? _stride : 1),
+        countdown(0),
+        started(Clock::now()),
+        last(-1),
+        taken()
+    {}
+
+    /**
+     * @brief Starts the clock anew and forgets the samples
+     */
+    void restart() {
+        started = Clock::now();
+        countdown = 0;
+        last = -1;
+        taken.clear();
+    }
+
+    bool due() {
+        if(countdown > 0) {
+            countdown--;
+            return false;
+        }
+
+        countdown = stride-1;
+        return last < 0 || now() - last >= interval;
+    }
+
+    void sample(size_t open, size_t closed, Cost f, size_t expanded) {
+        Sample s;
+        s.seconds = now();
+        s.open = open;
+        s.closed = closed;
+        s.f = f;
+        s.expanded = expanded;
+        s.residentBytes = residentBytes();
+
+        taken.push_back(s);
+        last = s.seconds;
+    }
+
+    const std::vector<Sample>& samples() const {
+        return taken;
+    }
+
+    /**
+     * @brief Expansions per second since the previous sample, 0 across the
+     *        start of another search sampled into the same timeline (its
+     *        expansion count starts anew)
+     */
+    double rate(size_t i) const {
+        if(i == 0 || taken[i].seconds <= taken[i-1].seconds || taken[i].expanded < taken[i-1].expanded) {
+            return 0;
+        }
+
+        return (taken[i].expanded - taken[i-1].expanded)/(taken[i].seconds - taken[i-1].seconds);
+    }
+
+    void writeCsv(std::ostream& os) const {
+        os<<"seconds,open,closed,f,expanded,expansions_per_second,resident_bytes\n";
+        for(size_t i = 0; i < taken.size(); i++) {
+            const Sample& s = taken[i];
+            os<<s.seconds<<','<<s.open<<','<<s.closed<<','<<s.f<<','<<s.expanded<<','<<rate(i)<<','<<s.residentBytes<<'\n';
+        }
+    }
+
+    /**
+     * @brief Chrome trace event format (also read by Perfetto): a counter
+     *        track per measure
+     */
+    void writeChromeTrace(std::ostream& os) const {
+        os<<"{\"traceEvents\":[";
+        for(size_t i = 0; i < taken.size(); i++) {
+            const Sample& s = taken[i];
+            const long long ts = s.seconds*1e6;
+
+            os<<(i == 0 ? "\n" : ",\n");
+            os<<"{\"name\":\"open\",\"ph\":\"C\",\"ts\":"<<ts<<",\"pid\":1,\"args\":{\"open\":"<<s.open<<"}},\n";
+            os<<"{\"name\":\"closed\",\"ph\":\"C\",\"ts\":"<<ts<<",\"pid\":1,\"args\":{\"closed\":"<<s.closed<<"}},\n";
+            os<<"{\"name\":\"f\",\"ph\":\"C\",\"ts\":"<<ts<<",\"pid\":1,\"args\":{\"f\":"<<s.f<<"}},\n";
+            os<<"{\"name\":\"expansions/s\",\"ph\":\"C\",\"ts\":"<<ts<<",\"pid\":1,\"args\":{\"rate\":"<<rate(i)<<"}},\n";
+            os<<"{\"name\":\"resident\",\"ph\":\"C\",\"ts\":"<<ts<<",\"pid\":1,\"args\":{\"bytes\":"<<s.residentBytes<<"}}";
+        }
+        os<<"\n]}\n";
+    }
+};
+
+/**
+ * @brief Timeline policy of GenericAStar that samples nothing, so the calls
+ *        compile away
+ */
+struct NoTimeline {
+    bool due() const {
+        return false;
+    }
+
+    void sample(size_t open, size_t closed, Cost f, size_t expanded) {
+    }
+};
+
+/**
+ * @brief Timeline policy of GenericAStar recording into a SearchTimeline
+ */
+struct TimelineSampler {
+    SearchTimeline* timeline;
+
+    TimelineSampler(SearchTimeline* _timeline):
+        timeline(_timeline)
+    {}
+
+    bool due() {
+        return timeline->due();
+    }
+
+    void sample(size_t open, size_t closed, Cost f, size_t expanded) {
+        timeline->sample(open, closed, f, expanded);
+    }
+};
+
+#endif // TIMELINE_H
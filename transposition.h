@@ -0,0 +1,182 @@
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+#include <stdint.h>
+#include <vector>
+#include <atomic>
+#include <boost/utility.hpp>
+#include <assert.h>
+#include "cost.h"
+
+/**
+ * @brief Fixed capacity table of best known g per state fingerprint.
+ *
+ * Buckets of `Ways` entries, a fingerprint lives in the bucket its low bits
+ * point to. Only entries of the current search (age) are found, a g from a
+ * search with another root would prune wrongly. When a bucket is full,
+ * entries left by an older search are replaced first, then the deepest one
+ * (largest g): shallow entries prune larger subtrees.
+ *
+ * Every entry is a pair of relaxed atomics {fingerprint^data, data}, so
+ * concurrent readers and writers never lock: a torn entry fails the xor
+ * check and reads as missing.
+ */
+template<unsigned Ways = 4>
+class TranspositionTable: public boost::noncopyable
+{
+    struct Entry {
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+
+        Entry():
+            check(0),
+            data(0)
+        {}
+    };
+
+    /**
+     * data = g (32 bits) | age (16 bits) | used (1 bit)
+     */
+    static uint64_t encode(Cost g, uint16_t age) {
+        return uint64_t(uint32_t(g)) | (uint64_t(age) << 32) | (uint64_t(1) << 48);
+    }
+
+    static Cost g(uint64_t data) {
+        return static_cast<Cost>(uint32_t(data));
+    }
+
+    static uint16_t age(uint64_t data) {
+        return uint16_t(data >> 32);
+    }
+
+    static bool used(uint64_t data) {
+        return (data >> 48) & 1;
+    }
+
+    std::vector<Entry> entries;
+    uint64_t mask;
+    uint16_t currentAge;
+
+    bool read(const Entry& e, uint64_t fingerprint, uint64_t& data) const {
+        data = e.data.load(std::memory_order_relaxed);
+        uint64_t check = e.check.load(std::memory_order_relaxed);
+
+        return used(data) && (check ^ data) == fingerprint;
+    }
+
+    void write(Entry& e, uint64_t fingerprint, uint64_t data) {
+        e.data.store(data, std::memory_order_relaxed);
+        e.check.store(fingerprint ^ data, std::memory_order_relaxed);
+    }
+
+    Entry* bucket(uint64_t fingerprint) {
+        return &entries[(fingerprint & mask)*Ways];
+    }
+
+    const Entry* bucket(uint64_t fingerprint) const {
+        return &entries[(fingerprint & mask)*Ways];
+    }
+
+public:
+
+    /**
+     * @brief Takes at most `bytes` of memory, rounded down to a power of two
+     *        number of buckets
+     */
+    explicit TranspositionTable(size_t bytes = 64 << 20):
+        entries(),
+        mask(0),
+        currentAge(0)
+    {
+        size_t buckets = 1;
+        while(2*buckets*Ways*sizeof(Entry) <= bytes) {
+            buckets *= 2;
+        }
+
+        std::vector<Entry>(buckets*Ways).swap(entries);
+        mask = buckets-1;
+    }
+
+    size_t capacity() const {
+        return entries.size();
+    }
+
+    size_t bytes() const {
+        return entries.size()*sizeof(Entry);
+    }
+
+    /**
+     * @brief Entries of previous searches are no longer found and become the
+     *        first to be replaced
+     */
+    void newSearch() {
+        currentAge++;
+    }
+
+    void clear() {
+        for(size_t i = 0; i < entries.size(); i++) {
+            entries[i].data.store(0, std::memory_order_relaxed);
+            entries[i].check.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    bool probe(uint64_t fingerprint, Cost& best) const {
+        const Entry* b = bucket(fingerprint);
+
+        for(unsigned i = 0; i < Ways; i++) {
+            uint64_t data;
+            if(read(b[i], fingerprint, data) && age(data) == currentAge) {
+                best = g(data);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void store(uint64_t fingerprint, Cost best) {
+        Entry* b = bucket(fingerprint);
+        Entry* victim = 0;
+        uint64_t victimData = 0;
+
+        for(unsigned i = 0; i < Ways; i++) {
+            uint64_t data;
+            if(read(b[i], fingerprint, data)) {
+                victim = &b[i];
+                break;
+            }
+
+            data = b[i].data.load(std::memory_order_relaxed);
+            if(!used(data)) {
+                victim = &b[i];
+                break;
+            }
+
+            bool older = victim != 0 && age(data) != currentAge && age(victimData) == currentAge;
+            bool deeper = victim != 0 && (age(data) != currentAge) == (age(victimData) != currentAge) && g(data) > g(victimData);
+
+            if(victim == 0 || older || deeper) {
+                victim = &b[i];
+                victimData = data;
+            }
+        }
+
+        write(*victim, fingerprint, encode(best, currentAge));
+    }
+
+    /**
+     * @brief True if the state was already reached at no greater cost,
+     *        otherwise records `reached` as its best cost
+     */
+    bool prune(uint64_t fingerprint, Cost reached) {
+        Cost best;
+        if(probe(fingerprint, best) && best <= reached) {
+            return true;
+        }
+
+        store(fingerprint, reached);
+        return false;
+    }
+};
+
+#endif // TRANSPOSITION_H